@@ -1,6 +1,6 @@
 #pragma once
 
-#include <QApplication>
+#include <QCoreApplication>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
@@ -34,22 +34,22 @@ constexpr bool isPortableMode()
  *   - Windows: %APPDATA%/VirtualGamePad/
  * - Debug builds: Always use application directory
  *
- * @warning Instantiate the QApplication object first
+ * @warning Instantiate the QCoreApplication (or QApplication) object first
  */
 inline QString getConfigDir()
 {
 #if defined(QT_DEBUG)
 	// Debug builds always use application directory
-	return QApplication::applicationDirPath();
+	return QCoreApplication::applicationDirPath();
 #else
 	if (isPortableMode())
 	{
 		// Portable mode: store alongside executable
 #if defined(_WIN32)
-		return QApplication::applicationDirPath();
+		return QCoreApplication::applicationDirPath();
 #else
 		// Linux: use parent directory (dist/ instead of dist/bin/)
-		return QFileInfo(QApplication::applicationDirPath()).dir().absolutePath();
+		return QFileInfo(QCoreApplication::applicationDirPath()).dir().absolutePath();
 #endif
 	}
 	else
@@ -76,13 +76,13 @@ inline QString getConfigDir()
  *   - Windows: %APPDATA%/VirtualGamePad/ (same as config)
  * - Debug builds: Always use application directory
  *
- * @warning Instantiate the QApplication object first
+ * @warning Instantiate the QCoreApplication (or QApplication) object first
  */
 inline QString getDataDir()
 {
 #if defined(QT_DEBUG)
 	// Debug builds always use application directory
-	return QApplication::applicationDirPath();
+	return QCoreApplication::applicationDirPath();
 #else
 	if (isPortableMode())
 	{
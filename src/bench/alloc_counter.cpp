@@ -0,0 +1,82 @@
+#include "alloc_counter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+// Constant initialized, so it works for allocations made before main()
+std::atomic<uint64_t> allocations{0};
+
+void countAllocation()
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+}
+} // namespace
+
+uint64_t alloc_counter::count()
+{
+	return allocations.load(std::memory_order_relaxed);
+}
+
+#if defined(__GLIBC__)
+// The executable's definitions take precedence over the C library's, the real ones stay reachable
+extern "C"
+{
+	void *__libc_malloc(std::size_t size);
+	void *__libc_calloc(std::size_t count, std::size_t size);
+	void *__libc_realloc(void *pointer, std::size_t size);
+
+	void *malloc(std::size_t size)
+	{
+		countAllocation();
+		return __libc_malloc(size);
+	}
+
+	void *calloc(std::size_t count, std::size_t size)
+	{
+		countAllocation();
+		return __libc_calloc(count, size);
+	}
+
+	void *realloc(void *pointer, std::size_t size)
+	{
+		countAllocation();
+		return __libc_realloc(pointer, size);
+	}
+}
+#else
+void *operator new(std::size_t size)
+{
+	countAllocation();
+	if (void *pointer = std::malloc(size != 0 ? size : 1))
+		return pointer;
+	throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Counts heap allocations of the whole process, to report allocations per operation.
+ *
+ * @details
+ * With glibc, malloc(), calloc() and realloc() are wrapped, which also catches the allocations
+ * of Qt containers and of operator new. Elsewhere only operator new is replaced,
+ * allocations Qt makes with malloc() directly are not counted there.
+ */
+namespace alloc_counter
+{
+/**
+ * @brief Allocations since the start of the process, from every thread.
+ */
+uint64_t count();
+} // namespace alloc_counter
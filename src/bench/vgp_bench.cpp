@@ -0,0 +1,473 @@
+/**
+ * @file vgp_bench.cpp
+ * @brief Microbenchmarks of the per-reading hot paths.
+ *
+ * @details
+ * Reports the time and the heap allocations per operation of the parser, the stick mapping, the keymap
+ * lookups, the axis conditioning and both executors, so the effect of a change to executor.cpp can be
+ * measured.
+ * Every benchmark runs in batches calibrated to the minimum time, the median batch is reported.
+ *
+ * The keymap fixtures load a real KeymapProfile, the one given with `--profile`, or the default
+ * mappings saved to a temporary profile and loaded back like the app loads any other.
+ *
+ * The executor benchmarks create the virtual devices and inject real input into the desktop session,
+ * so they only run with `--devices`. On Linux, they also report the uinput write() calls per reading,
+ * next to the events written, which is what the writes were before the events were batched.
+ *
+ * Build in Release, the debug build logs every parsed reading.
+ */
+
+#include "../networking/executor.hpp"
+#include "../settings/keymap_profile.hpp"
+#include "../settings/settings_singleton.hpp"
+#include "alloc_counter.hpp"
+#ifdef __linux__
+#include "../simulation/linux/uinputFrame.hpp"
+#endif
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numbers>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr std::array<GamepadButtons, 14> BUTTONS = {GamepadButtons_Menu,
+													GamepadButtons_View,
+													GamepadButtons_A,
+													GamepadButtons_B,
+													GamepadButtons_X,
+													GamepadButtons_Y,
+													GamepadButtons_DPadUp,
+													GamepadButtons_DPadDown,
+													GamepadButtons_DPadLeft,
+													GamepadButtons_DPadRight,
+													GamepadButtons_LeftShoulder,
+													GamepadButtons_RightShoulder,
+													GamepadButtons_LeftThumbstick,
+													GamepadButtons_RightThumbstick};
+
+/**
+ * @brief Keeps the compiler from optimizing away a result that is never used.
+ */
+template <typename T> void keep(const T &value)
+{
+#if defined(__GNUC__)
+	asm volatile("" : : "g"(&value) : "memory");
+#else
+	static const void *volatile sink;
+	sink = &value;
+#endif
+}
+
+class Runner
+{
+  public:
+	/**
+	 * Batches per benchmark, the median one is reported.
+	 */
+	static constexpr std::size_t BATCHES = 5;
+
+	Runner(const QString &filter, std::chrono::milliseconds minTime) : m_filter(filter), m_minTime(minTime)
+	{
+		std::printf("%-52s %12s %12s %14s\n", "benchmark", "ns/op", "allocs/op", "iterations");
+	}
+
+	/**
+	 * @brief Measures @p body, called with the iteration index so fixtures can vary their input.
+	 */
+	template <typename Body> void run(const char *name, Body &&body)
+	{
+		if (!selected(name))
+			return;
+
+		// Grow the batch until it takes its share of the minimum time
+		const Clock::duration batchTime = m_minTime / BATCHES;
+		uint64_t iterations = 1;
+		while (time(body, iterations) < batchTime && iterations < (uint64_t{1} << 32))
+			iterations *= 2;
+
+		std::array<double, BATCHES> samples{};
+		uint64_t allocations = 0;
+		for (double &sample : samples)
+		{
+			const uint64_t allocationsBefore = alloc_counter::count();
+			const Clock::duration elapsed = time(body, iterations);
+			allocations += alloc_counter::count() - allocationsBefore;
+			const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+			sample = static_cast<double>(nanoseconds.count()) / static_cast<double>(iterations);
+		}
+		std::sort(samples.begin(), samples.end());
+
+		std::printf("%-52s %12.1f %12.3f %14llu\n",
+					name,
+					samples[BATCHES / 2],
+					static_cast<double>(allocations) / static_cast<double>(iterations * BATCHES),
+					static_cast<unsigned long long>(iterations));
+		std::fflush(stdout);
+	}
+
+	/**
+	 * @brief Calls made to the bodies of all benchmarks so far, calibration included.
+	 */
+	uint64_t calls() const
+	{
+		return m_calls;
+	}
+
+	void skip(const char *name, const QString &reason) const
+	{
+		if (selected(name))
+			std::printf("%-52s skipped: %s\n", name, qPrintable(reason));
+	}
+
+  private:
+	bool selected(const char *name) const
+	{
+		return m_filter.isEmpty() || QString::fromLatin1(name).contains(m_filter, Qt::CaseInsensitive);
+	}
+
+	template <typename Body> Clock::duration time(Body &body, uint64_t iterations)
+	{
+		const Clock::time_point start = Clock::now();
+		for (uint64_t i = 0; i < iterations; i++)
+			body(i);
+		const Clock::time_point end = Clock::now();
+		m_calls += iterations;
+		return end - start;
+	}
+
+	QString m_filter;
+	std::chrono::milliseconds m_minTime;
+	uint64_t m_calls = 0;
+};
+
+std::vector<char> marshal(const vgp_data_exchange_gamepad_reading &reading)
+{
+	std::vector<char> bytes(vgp_data_exchange_gamepad_reading_marshal_len(&reading));
+	bytes.resize(vgp_data_exchange_gamepad_reading_marshal(&reading, bytes.data()));
+	return bytes;
+}
+
+/**
+ * @brief A reading with every field set, the largest the app sends.
+ */
+vgp_data_exchange_gamepad_reading fullReading()
+{
+	vgp_data_exchange_gamepad_reading reading{};
+	reading.buttons_down = GamepadButtons_A | GamepadButtons_DPadUp;
+	reading.buttons_up = GamepadButtons_B | GamepadButtons_RightShoulder;
+	reading.left_trigger = 0.25f;
+	reading.right_trigger = 0.75f;
+	reading.left_thumbstick_x = 0.7f;
+	reading.left_thumbstick_y = -0.3f;
+	reading.right_thumbstick_x = -0.9f;
+	reading.right_thumbstick_y = 0.1f;
+	return reading;
+}
+
+/**
+ * @brief Stick positions all around the circle, at several distances from the center.
+ */
+std::vector<std::pair<float, float>> stickPositions()
+{
+	std::vector<std::pair<float, float>> positions;
+	for (int i = 0; i < 1024; i++)
+	{
+		const double angle = 2.0 * std::numbers::pi * i / 64.0;
+		const double radius = (i % 16 + 1) / 16.0;
+		positions.emplace_back(static_cast<float>(radius * std::cos(angle)),
+							   static_cast<float>(radius * std::sin(angle)));
+	}
+	return positions;
+}
+
+/**
+ * @brief Alternates presses and releases of @p button, so the executor does the same work every time.
+ */
+vgp_data_exchange_gamepad_reading toggling(GamepadButtons button, uint64_t i)
+{
+	vgp_data_exchange_gamepad_reading reading{};
+	if (i % 2 == 0)
+		reading.buttons_down = button;
+	else
+		reading.buttons_up = button;
+	return reading;
+}
+
+void benchmarkParser(Runner &runner)
+{
+	const std::vector<char> idle = marshal(vgp_data_exchange_gamepad_reading{});
+	const std::vector<char> full = marshal(fullReading());
+
+	runner.run("parse_gamepad_state/idle",
+			   [&idle](uint64_t)
+			   {
+				   keep(parse_gamepad_state(idle.data(), idle.size()));
+			   });
+	runner.run("parse_gamepad_state/full",
+			   [&full](uint64_t)
+			   {
+				   keep(parse_gamepad_state(full.data(), full.size()));
+			   });
+	runner.run("parse_gamepad_state/incomplete",
+			   [&full](uint64_t)
+			   {
+				   keep(parse_gamepad_state(full.data(), full.size() / 2));
+			   });
+
+	// A burst of readings in one receive, one call per reading or one call for all of them
+	std::vector<char> burst;
+	for (int i = 0; i < 32; i++)
+		burst.insert(burst.end(), full.begin(), full.end());
+	runner.run("parse_gamepad_state/burst32",
+			   [&burst](uint64_t)
+			   {
+				   std::size_t offset = 0;
+				   while (offset < burst.size())
+				   {
+					   const ParseResult result =
+						   parse_gamepad_state(burst.data() + offset, burst.size() - offset);
+					   keep(result);
+					   offset += result.bytes_consumed;
+				   }
+			   });
+	runner.run("parse_gamepad_states/burst32",
+			   [&burst](uint64_t)
+			   {
+				   std::array<vgp_data_exchange_gamepad_reading, 32> readings;
+				   keep(parse_gamepad_states(std::as_bytes(std::span(burst)), readings));
+				   keep(readings);
+			   });
+}
+
+void benchmarkMapping(Runner &runner, const KeymapProfile &profile)
+{
+	const auto positions = stickPositions();
+	runner.run("circleToSquare",
+			   [&positions](uint64_t i)
+			   {
+				   const auto &[x, y] = positions[i % positions.size()];
+				   keep(circleToSquare(x, y));
+			   });
+
+	runner.run("KeymapProfile::buttonMap",
+			   [&profile](uint64_t i)
+			   {
+				   keep(profile.buttonMap(BUTTONS[i % BUTTONS.size()]));
+			   });
+	runner.run("KeymapProfile::thumbstickInput",
+			   [&profile](uint64_t i)
+			   {
+				   keep(profile.thumbstickInput(i % 2 == 0 ? Thumbstick_Left : Thumbstick_Right));
+			   });
+
+	KeymapPlan plan;
+	uint64_t generation = 0;
+	runner.run("KeymapProfile::refreshPlan",
+			   [&profile, &plan, &generation](uint64_t)
+			   {
+				   profile.refreshPlan(plan, generation);
+				   keep(generation);
+			   });
+
+	// Every feature of the responses, the defaults would skip the kernel
+	AxisResponse stick;
+	stick.deadzone = 0.1f;
+	stick.antiDeadzone = 0.05f;
+	stick.saturation = 0.95f;
+	stick.exponent = 1.5f;
+	AxisResponse trigger = stick;
+	trigger.curve = AxisResponse::Curve::Bezier;
+	AxisResponse axial = stick;
+	axial.shape = AxisResponse::Shape::Axial;
+	const AxisTables tables = AxisTables::compile(stick, axial, trigger, trigger);
+	runner.run("AxisTables::apply",
+			   [&positions, &tables](uint64_t i)
+			   {
+				   const auto &[x, y] = positions[i % positions.size()];
+				   float axes[AxisTables::AXIS_COUNT] = {x, y, y, x, std::abs(x), std::abs(y)};
+				   tables.apply(axes);
+				   keep(axes);
+			   });
+	runner.run("AxisTables::applyScalar",
+			   [&positions, &tables](uint64_t i)
+			   {
+				   const auto &[x, y] = positions[i % positions.size()];
+				   float axes[AxisTables::AXIS_COUNT] = {x, y, y, x, std::abs(x), std::abs(y)};
+				   tables.applyScalar(axes);
+				   keep(axes);
+			   });
+}
+
+/**
+ * @brief Runs an executor benchmark, then prints the uinput writes and events per reading on Linux.
+ */
+template <typename Body> void runInjecting(Runner &runner, const char *name, Body &&body)
+{
+#ifdef __linux__
+	const UinputFrame::Counters before = UinputFrame::counters();
+	const uint64_t callsBefore = runner.calls();
+#endif
+	runner.run(name, std::forward<Body>(body));
+#ifdef __linux__
+	const UinputFrame::Counters after = UinputFrame::counters();
+	if (const uint64_t calls = runner.calls() - callsBefore; calls > 0)
+	{
+		std::printf("%-52s %12.2f writes/op %9.2f events/op\n",
+					"  uinput",
+					static_cast<double>(after.writes - before.writes) / static_cast<double>(calls),
+					static_cast<double>(after.events - before.events) / static_cast<double>(calls));
+		std::fflush(stdout);
+	}
+#endif
+}
+
+void benchmarkExecutors(Runner &runner, bool devices)
+{
+	const char *keyboardIdle = "KeyboardMouseExecutor::inject_gamepad_state/idle";
+	const char *keyboardButton = "KeyboardMouseExecutor::inject_gamepad_state/button";
+	const char *keyboardSticks = "KeyboardMouseExecutor::inject_gamepad_state/sticks";
+	const char *gamepadButton = "GamepadExecutor::inject_gamepad_state/button";
+	const char *gamepadSticks = "GamepadExecutor::inject_gamepad_state/sticks";
+	if (!devices)
+	{
+		for (const char *name :
+			 {keyboardIdle, keyboardButton, keyboardSticks, gamepadButton, gamepadSticks})
+		{
+			runner.skip(name, "injects input into the session, run with --devices");
+		}
+		return;
+	}
+
+	const auto positions = stickPositions();
+	auto sticks = [&positions](uint64_t i)
+	{
+		vgp_data_exchange_gamepad_reading reading{};
+		std::tie(reading.left_thumbstick_x, reading.left_thumbstick_y) = positions[i % positions.size()];
+		std::tie(reading.right_thumbstick_x, reading.right_thumbstick_y) =
+			positions[(i + 512) % positions.size()];
+		return reading;
+	};
+
+	try
+	{
+		KeyboardMouseExecutor executor;
+		const vgp_data_exchange_gamepad_reading idle{};
+		runInjecting(runner,
+					 keyboardIdle,
+					 [&executor, &idle](uint64_t)
+					 {
+						 executor.inject_gamepad_state(idle);
+					 });
+		runInjecting(runner,
+					 keyboardButton,
+					 [&executor](uint64_t i)
+					 {
+						 executor.inject_gamepad_state(toggling(GamepadButtons_A, i));
+					 });
+		runInjecting(runner,
+					 keyboardSticks,
+					 [&executor, &sticks](uint64_t i)
+					 {
+						 executor.inject_gamepad_state(sticks(i));
+					 });
+	}
+	catch (const std::exception &e)
+	{
+		for (const char *name : {keyboardIdle, keyboardButton, keyboardSticks})
+			runner.skip(name, QString::fromUtf8(e.what()));
+	}
+
+	try
+	{
+		GamepadExecutor executor;
+		runInjecting(runner,
+					 gamepadButton,
+					 [&executor](uint64_t i)
+					 {
+						 executor.inject_gamepad_state(toggling(GamepadButtons_A, i));
+					 });
+		runInjecting(runner,
+					 gamepadSticks,
+					 [&executor, &sticks](uint64_t i)
+					 {
+						 executor.inject_gamepad_state(sticks(i));
+					 });
+	}
+	catch (const std::exception &e)
+	{
+		for (const char *name : {gamepadButton, gamepadSticks})
+			runner.skip(name, QString::fromUtf8(e.what()));
+	}
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setOrganizationName("kitswas");
+	QCoreApplication::setOrganizationDomain("io.github.kitswas");
+	QCoreApplication::setApplicationName("VirtualGamePad");
+	QCoreApplication::setApplicationVersion(APP_VERSION);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Microbenchmarks of the VirtualGamePad hot paths");
+	parser.addHelpOption();
+	parser.addVersionOption();
+	parser.addOptions({
+		{{"f", "filter"}, "Only runs the benchmarks whose name contains this text.", "text"},
+		{"min-time", "Minimum time spent on each benchmark.", "ms", "500"},
+		{"profile", "Keymap profile file (.ini) to load, default mappings otherwise.", "file"},
+		{"devices", "Also benchmarks the executors. Creates virtual devices and injects input."},
+	});
+	parser.process(app);
+
+	bool ok = false;
+	const int minTime = parser.value("min-time").toInt(&ok);
+	if (!ok || minTime <= 0)
+	{
+		qCritical() << "Invalid minimum time:" << parser.value("min-time");
+		return 2;
+	}
+
+	// The executor reads the active profile, so the fixture is loaded into it
+	KeymapProfile &profile = SettingsSingleton::instance().activeKeymapProfile();
+	QString profilePath = parser.value("profile");
+	QTemporaryDir profileDir;
+	if (profilePath.isEmpty())
+	{
+		KeymapProfile defaults;
+		defaults.initializeDefaultMappings();
+		profilePath = profileDir.filePath("bench.ini");
+		if (!profileDir.isValid() || !defaults.save(profilePath))
+		{
+			qCritical() << "Unable to save the default keymap profile to" << profilePath;
+			return 1;
+		}
+	}
+	if (!profile.load(profilePath))
+	{
+		qCritical() << "Unable to load the keymap profile" << profilePath;
+		return 1;
+	}
+
+	Runner runner(parser.value("filter"), std::chrono::milliseconds(minTime));
+	benchmarkParser(runner);
+	benchmarkMapping(runner, profile);
+	benchmarkExecutors(runner, parser.isSet("devices"));
+	return 0;
+}
@@ -0,0 +1,402 @@
+/**
+ * @file vgpd.cpp
+ * @brief Headless server, without any widget.
+ *
+ * @details
+ * Serves the same protocol with the same executors and settings as the desktop app,
+ * but starts in milliseconds and runs without a display: as a systemd service,
+ * on a machine that is only used for playing, or as the target of automated benchmarks.
+ *
+ * Options given on the command line override the saved settings for this run only.
+ *
+ * With `--replay`, a capture recorded with `--capture` is fed through the parser and the executor
+ * instead of serving clients, see CaptureReplayer.
+ */
+
+#include "../appdir.hpp"
+#include "../networking/device_pool.hpp"
+#include "../networking/network_worker.hpp"
+#include "../networking/replay.hpp"
+#include "../settings/settings_singleton.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <cstdio>
+
+#ifdef __linux__
+#include <QSocketNotifier>
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace
+{
+#ifdef __linux__
+int signalSockets[2] = {-1, -1};
+
+void handleTermination(int)
+{
+	// Only async-signal-safe calls here, the notifier below does the rest on the event loop
+	char signal = 1;
+	[[maybe_unused]] auto written = ::write(signalSockets[0], &signal, sizeof(signal));
+}
+
+/**
+ * @brief Quits the event loop on SIGINT and SIGTERM, so the virtual devices are released cleanly.
+ */
+void installSignalHandlers(QCoreApplication &app)
+{
+	if (::socketpair(AF_UNIX, SOCK_STREAM, 0, signalSockets) != 0)
+	{
+		qWarning() << "Failed to create the signal socket pair, signals will not stop the server cleanly";
+		return;
+	}
+	auto *notifier = new QSocketNotifier(signalSockets[1], QSocketNotifier::Read, &app);
+	QObject::connect(notifier,
+					 &QSocketNotifier::activated,
+					 &app,
+					 []()
+					 {
+						 char signal;
+						 [[maybe_unused]] auto received = ::read(signalSockets[1], &signal, sizeof(signal));
+						 qInfo() << "Termination requested";
+						 QCoreApplication::quit();
+					 });
+
+	struct sigaction action = {};
+	action.sa_handler = handleTermination;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = SA_RESTART;
+	sigaction(SIGINT, &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+}
+#elif defined(_WIN32)
+BOOL WINAPI handleConsoleControl(DWORD)
+{
+	// Runs on a thread of its own, queue the quit on the event loop
+	QMetaObject::invokeMethod(QCoreApplication::instance(), &QCoreApplication::quit, Qt::QueuedConnection);
+	return TRUE;
+}
+
+void installSignalHandlers(QCoreApplication &)
+{
+	SetConsoleCtrlHandler(handleConsoleControl, TRUE);
+}
+#endif
+
+/**
+ * @brief Applies the command line options on top of the saved settings.
+ * @return false if an option has an invalid value, the error has been printed.
+ */
+bool applyOptions(const QCommandLineParser &parser, ServerConfig &config)
+{
+	if (parser.isSet("port"))
+	{
+		bool ok = false;
+		const uint port = parser.value("port").toUInt(&ok);
+		if (!ok || port > 65535)
+		{
+			qCritical() << "Invalid port:" << parser.value("port");
+			return false;
+		}
+		config.port = static_cast<quint16>(port);
+	}
+
+	if (parser.isSet("transport"))
+	{
+		const QString transport = parser.value("transport").toLower();
+		if (transport == "tcp")
+			config.transport = TransportMode::Tcp;
+		else if (transport == "udp")
+			config.transport = TransportMode::Udp;
+		else
+		{
+			qCritical() << "Invalid transport:" << transport << "(expected tcp or udp)";
+			return false;
+		}
+	}
+
+	if (parser.isSet("executor"))
+	{
+		const QString executor = parser.value("executor").toLower();
+		if (executor == "gamepad")
+			config.executorType = ExecutorType::GamepadExecutor;
+		else if (executor == "keyboard-mouse")
+			config.executorType = ExecutorType::KeyboardMouseExecutor;
+		else
+		{
+			qCritical() << "Invalid executor:" << executor << "(expected gamepad or keyboard-mouse)";
+			return false;
+		}
+	}
+
+	if (parser.isSet("injection-rate"))
+	{
+		bool ok = false;
+		const int rate = parser.value("injection-rate").toInt(&ok);
+		if (!ok || rate < 0)
+		{
+			qCritical() << "Invalid injection rate:" << parser.value("injection-rate");
+			return false;
+		}
+		config.injectionRate = rate;
+	}
+
+	if (parser.isSet("stall-timeout"))
+	{
+		bool ok = false;
+		const int timeout = parser.value("stall-timeout").toInt(&ok);
+		if (!ok || timeout < 0)
+		{
+			qCritical() << "Invalid stall timeout:" << parser.value("stall-timeout");
+			return false;
+		}
+		config.stallTimeoutMs = timeout;
+	}
+
+	config.ioUring = parser.isSet("io-uring");
+
+	config.lowLatency.enabled = parser.isSet("low-latency");
+	if (parser.isSet("rt-priority"))
+	{
+		bool ok = false;
+		const int priority = parser.value("rt-priority").toInt(&ok);
+		if (!ok || priority < 0 || priority > 99)
+		{
+			qCritical() << "Invalid real-time priority:" << parser.value("rt-priority")
+						<< "(expected 0 to 99)";
+			return false;
+		}
+		config.lowLatency.realtimePriority = priority;
+	}
+	if (parser.isSet("cpu"))
+	{
+		bool ok = false;
+		const int cpu = parser.value("cpu").toInt(&ok);
+		if (!ok || cpu < 0)
+		{
+			qCritical() << "Invalid CPU:" << parser.value("cpu");
+			return false;
+		}
+		config.lowLatency.cpu = cpu;
+	}
+
+	if (parser.isSet("device-pool"))
+	{
+		bool ok = false;
+		const int pooled = parser.value("device-pool").toInt(&ok);
+		if (!ok || pooled < 0)
+		{
+			qCritical() << "Invalid device pool size:" << parser.value("device-pool");
+			return false;
+		}
+		config.pooledDevices = static_cast<std::size_t>(pooled);
+	}
+
+	if (parser.isSet("local"))
+		config.localSocket = parser.value("local");
+
+	if (parser.isSet("capture"))
+		config.capturePath = parser.value("capture");
+
+	if (parser.isSet("pointer-curve"))
+	{
+		bool ok = false;
+		const double curve = parser.value("pointer-curve").toDouble(&ok);
+		if (!ok || curve < SettingsSingleton::MIN_POINTER_CURVE ||
+			curve > SettingsSingleton::MAX_POINTER_CURVE)
+		{
+			qCritical() << "Invalid pointer curve:" << parser.value("pointer-curve")
+						<< "(expected 0.5 to 4)";
+			return false;
+		}
+		// Not saved for the desktop app, this run only
+		SettingsSingleton::instance().usePointerCurve(curve);
+	}
+
+	if (parser.isSet("profile"))
+	{
+		auto &settings = SettingsSingleton::instance();
+		const QString profile = parser.value("profile");
+		if (!settings.profileExists(profile))
+		{
+			qCritical() << "No such keymap profile:" << profile;
+			return false;
+		}
+		// Not made the active profile of the desktop app, this run only
+		settings.activeKeymapProfile().load(settings.getProfilesDir() + "/" + profile + ".ini");
+	}
+	return true;
+}
+
+void printStats(quint64 sessionId, const SessionStats &stats)
+{
+	std::printf("session=%llu format=%s readings=%llu injected=%llu collapsed=%llu dropped=%llu "
+				"parse_errors=%llu stalls=%llu interval_p99_us=%llu inject_p99_us=%llu e2e_p99_us=%llu\n",
+				static_cast<unsigned long long>(sessionId),
+				stats.compactFrames ? "compact" : "colfer",
+				static_cast<unsigned long long>(stats.requestCount),
+				static_cast<unsigned long long>(stats.injectedCount),
+				static_cast<unsigned long long>(stats.collapsedCount),
+				static_cast<unsigned long long>(stats.droppedCount),
+				static_cast<unsigned long long>(stats.parseErrors),
+				static_cast<unsigned long long>(stats.stallCount),
+				static_cast<unsigned long long>(stats.interArrivalTime.p99 / 1000),
+				static_cast<unsigned long long>(stats.injectTime.p99 / 1000),
+				static_cast<unsigned long long>(stats.endToEndLatency.p99 / 1000));
+	std::fflush(stdout);
+}
+
+/**
+ * @brief Replays a capture with the configured executor and prints a summary.
+ * @return The exit code of the process.
+ */
+int replay(const QString &path, const ServerConfig &config, CaptureReplayer::Timing timing)
+{
+	CaptureReader reader;
+	if (!reader.open(path))
+	{
+		qCritical().noquote() << "Unable to open the capture" << path << ":" << reader.errorString();
+		return 1;
+	}
+
+	CaptureReplayer replayer(
+		[&config]()
+		{
+			return createExecutor(config.executorType);
+		},
+		timing);
+	try
+	{
+		replayer.run(reader);
+	}
+	catch (const std::exception &e)
+	{
+		qCritical() << "Failed to create an executor:" << e.what();
+		return 1;
+	}
+
+	const HistogramSummary parse = replayer.parseTime().summary();
+	const HistogramSummary inject = replayer.injectTime().summary();
+	std::printf("replayed records=%llu sessions=%zu readings=%llu parse_errors=%llu "
+				"parse_p50_ns=%llu parse_p99_ns=%llu inject_p50_ns=%llu inject_p99_ns=%llu\n",
+				static_cast<unsigned long long>(replayer.recordCount()),
+				replayer.sessionCount(),
+				static_cast<unsigned long long>(replayer.readingCount()),
+				static_cast<unsigned long long>(replayer.parseErrors()),
+				static_cast<unsigned long long>(parse.p50),
+				static_cast<unsigned long long>(parse.p99),
+				static_cast<unsigned long long>(inject.p50),
+				static_cast<unsigned long long>(inject.p99));
+	return 0;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setOrganizationName("kitswas");
+	QCoreApplication::setOrganizationDomain("io.github.kitswas");
+	QCoreApplication::setApplicationName("VirtualGamePad");
+	QCoreApplication::setApplicationVersion(APP_VERSION);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Headless VirtualGamePad server");
+	parser.addHelpOption();
+	parser.addVersionOption();
+	parser.addOptions({
+		{{"p", "port"}, "Port to listen on, 0 picks a free one.", "port"},
+		{{"t", "transport"}, "tcp or udp.", "transport"},
+		{{"e", "executor"}, "gamepad or keyboard-mouse.", "executor"},
+		{{"r", "injection-rate"}, "Fixed injection rate in Hz, 0 injects on arrival.", "hz"},
+		{"profile", "Keymap profile for the keyboard-mouse executor.", "name"},
+		{"pointer-curve",
+		 "Acceleration curve of the sticks moving the mouse, 1 is linear, up to 4. Overrides the setting.",
+		 "exponent"},
+		{"stall-timeout",
+		 "Release the held inputs of a client silent for this long, 0 never does. Overrides the "
+		 "setting, 500 ms by default. Clients sending heartbeats are released after 150 ms "
+		 "whatever this is.",
+		 "ms"},
+		{"local",
+		 "Also accept clients on the same machine on this Unix domain socket, they send their "
+		 "readings through shared memory (Linux).",
+		 "path"},
+		{"io-uring", "Receive through io_uring (Linux 6.0+), falls back to Qt sockets where unavailable."},
+		{"low-latency",
+		 "Real-time scheduling for the input threads and QoS marking of client sockets, as far as "
+		 "permitted. What was applied is logged."},
+		{"rt-priority",
+		 "With --low-latency, SCHED_FIFO priority, 0 only raises the nice level (default 10).",
+		 "0-99"},
+		{"cpu", "With --low-latency, pin the input threads to this CPU.", "n"},
+		{"device-pool",
+		 "Input devices kept created for clients reconnecting, 0 creates them for every client "
+		 "(default 1).",
+		 "n"},
+		{{"s", "stats"}, "Print the stats of every session once per second to stdout."},
+		{"capture", "Record every received byte to a capture file for replay.", "file"},
+		{"replay", "Replay a capture file through the executor instead of serving clients.", "file"},
+		{"replay-fast", "With --replay, replay as fast as possible instead of at the original timing."},
+	});
+	parser.process(app);
+
+	qInfo() << "Build mode:" << (isPortableMode() ? "PORTABLE" : "INSTALLABLE");
+	qInfo() << "Config directory:" << getConfigDir();
+
+	ServerConfig config = ServerConfig::fromSettings();
+	if (!applyOptions(parser, config))
+		return 2;
+
+	if (parser.isSet("replay"))
+	{
+		const auto timing =
+			parser.isSet("replay-fast") ? CaptureReplayer::Timing::Fast : CaptureReplayer::Timing::Original;
+		return replay(parser.value("replay"), config, timing);
+	}
+
+	installSignalHandlers(app);
+
+	NetworkWorker worker;
+	int exitCode = 0;
+	QObject::connect(&worker,
+					 &NetworkWorker::listening,
+					 &app,
+					 [&config](quint16 port)
+					 {
+						 // On stdout, so scripts can pick up the port when it was chosen automatically
+						 const char *transport = config.transport == TransportMode::Udp ? "udp" : "tcp";
+						 std::printf("listening %s %u\n", transport, static_cast<unsigned>(port));
+						 std::fflush(stdout);
+					 });
+	QObject::connect(&worker,
+					 &NetworkWorker::listenFailed,
+					 &app,
+					 [&exitCode](const QString &error)
+					 {
+						 qCritical().noquote() << "Unable to start the server:" << error;
+						 exitCode = 1;
+						 QCoreApplication::exit(exitCode);
+					 });
+	if (parser.isSet("stats"))
+		QObject::connect(&worker, &NetworkWorker::statsUpdated, &app, printStats);
+	QObject::connect(&app, &QCoreApplication::aboutToQuit, &worker, &NetworkWorker::stop);
+
+	// Queued, so a failure to listen quits a running event loop
+	QMetaObject::invokeMethod(
+		&worker,
+		[&worker, &config]()
+		{
+			worker.startListening(config);
+		},
+		Qt::QueuedConnection);
+
+	const int result = QCoreApplication::exec();
+	DevicePool::instance().close();
+	qInfo() << "Server stopped.";
+	return exitCode != 0 ? exitCode : result;
+}
@@ -0,0 +1,114 @@
+#include "patterns.hpp"
+
+#include "../../VGP_Data_Exchange/C/GameButtons.h"
+
+#include <array>
+#include <cmath>
+#include <numbers>
+
+namespace
+{
+constexpr std::array<uint32_t, 4> FACE_BUTTONS = {
+	GamepadButtons_A,
+	GamepadButtons_B,
+	GamepadButtons_X,
+	GamepadButtons_Y,
+};
+
+constexpr uint32_t ALL_BUTTONS = 0x3FFF;
+} // namespace
+
+bool parsePattern(const QString &name, Pattern &pattern)
+{
+	const QString lower = name.toLower();
+	if (lower == "idle")
+		pattern = Pattern::Idle;
+	else if (lower == "circle")
+		pattern = Pattern::Circle;
+	else if (lower == "sweep")
+		pattern = Pattern::Sweep;
+	else if (lower == "buttons")
+		pattern = Pattern::Buttons;
+	else if (lower == "mash")
+		pattern = Pattern::Mash;
+	else
+		return false;
+	return true;
+}
+
+PatternScript::PatternScript(Pattern pattern, uint32_t seed) : m_pattern(pattern), m_state(seed | 1)
+{
+}
+
+uint32_t PatternScript::random()
+{
+	// xorshift32, cheap and good enough to vary the inputs
+	m_state ^= m_state << 13;
+	m_state ^= m_state >> 17;
+	m_state ^= m_state << 5;
+	return m_state;
+}
+
+void PatternScript::next(double seconds, vgp_data_exchange_gamepad_reading &reading, uint32_t &held)
+{
+	reading = vgp_data_exchange_gamepad_reading{};
+	uint32_t pressed = 0;
+
+	switch (m_pattern)
+	{
+	case Pattern::Idle:
+		break;
+	case Pattern::Circle:
+	{
+		// One turn per second
+		const double angle = 2.0 * std::numbers::pi * seconds;
+		reading.left_thumbstick_x = static_cast<float>(std::cos(angle));
+		reading.left_thumbstick_y = static_cast<float>(std::sin(angle));
+		reading.right_thumbstick_x = static_cast<float>(-std::sin(angle));
+		reading.right_thumbstick_y = static_cast<float>(std::cos(angle));
+		reading.left_trigger = static_cast<float>(0.5 + 0.5 * std::sin(angle));
+		reading.right_trigger = static_cast<float>(0.5 - 0.5 * std::sin(angle));
+		break;
+	}
+	case Pattern::Sweep:
+	{
+		// X from -1 to 1 in the first second, then Y, then again
+		const double phase = std::fmod(seconds, 2.0);
+		const auto position = static_cast<float>(std::fmod(phase, 1.0) * 2.0 - 1.0);
+		if (phase < 1.0)
+			reading.left_thumbstick_x = position;
+		else
+			reading.left_thumbstick_y = position;
+		break;
+	}
+	case Pattern::Buttons:
+	{
+		// Press for 100 ms, release for 100 ms, next button
+		const auto step = static_cast<uint64_t>(seconds * 10.0);
+		if (step % 2 == 0)
+			pressed = FACE_BUTTONS[(step / 2) % FACE_BUTTONS.size()];
+		break;
+	}
+	case Pattern::Mash:
+	{
+		pressed = random() & ALL_BUTTONS;
+		auto axis = [this]()
+		{
+			return static_cast<float>(random() % 2001) / 1000.0f - 1.0f;
+		};
+		reading.left_thumbstick_x = axis();
+		reading.left_thumbstick_y = axis();
+		reading.right_thumbstick_x = axis();
+		reading.right_thumbstick_y = axis();
+		reading.left_trigger = (axis() + 1.0f) / 2.0f;
+		reading.right_trigger = (axis() + 1.0f) / 2.0f;
+		break;
+	}
+	}
+
+	// Edges relative to the previous reading, like the app sends them
+	reading.buttons_down = pressed & ~m_held;
+	reading.buttons_up = m_held & ~pressed;
+	m_held = pressed;
+	held = pressed;
+}
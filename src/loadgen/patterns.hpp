@@ -0,0 +1,49 @@
+#pragma once
+
+#include "../../VGP_Data_Exchange/C/Colfer.h"
+
+#include <QString>
+#include <cstdint>
+
+/**
+ * @brief Scripted inputs of the load generator.
+ */
+enum class Pattern
+{
+	Idle,		// Nothing pressed, sticks centered. Smallest readings, measures the per-reading overhead
+	Circle,		// Both sticks turning, triggers pulsing. Every reading carries all analog values
+	Sweep,		// Left stick sweeping each axis from one end to the other
+	Buttons,	// One face button after the other, pressed for 100 ms each
+	Mash		// Random buttons and sticks changing on every reading, the worst case for coalescing
+};
+
+/**
+ * @brief Parses a pattern name as given on the command line.
+ * @return false if @p name is not a pattern.
+ */
+bool parsePattern(const QString &name, Pattern &pattern);
+
+/**
+ * @brief Generates the readings of a pattern, with the button edges a real client would send.
+ */
+class PatternScript
+{
+  public:
+	/**
+	 * @param seed Makes the random patterns of parallel connections differ, and runs reproducible.
+	 */
+	PatternScript(Pattern pattern, uint32_t seed);
+
+	/**
+	 * @brief Computes the reading at @p seconds since the start.
+	 * @param held Set to the buttons held after this reading, the absolute state of the UDP frame.
+	 */
+	void next(double seconds, vgp_data_exchange_gamepad_reading &reading, uint32_t &held);
+
+  private:
+	uint32_t random();
+
+	Pattern m_pattern;
+	uint32_t m_state;
+	uint32_t m_held = 0;
+};
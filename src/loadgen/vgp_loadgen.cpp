@@ -0,0 +1,739 @@
+/**
+ * @file vgp_loadgen.cpp
+ * @brief Synthetic clients for stress-testing the server.
+ *
+ * @details
+ * Opens any number of connections to a server and streams scripted readings on each at a fixed rate,
+ * over TCP (marshalled readings, as the app sends them) or UDP (see udp_frame.hpp).
+ * Every connection runs on a thread of its own with blocking sockets, so the schedule of one
+ * connection never waits for another.
+ *
+ * Once per second, and at the end, it reports what was achieved: the sending rate, the throughput,
+ * how late sends were against their schedule and how often a connection had to wait for the server
+ * to read. When the achieved rate falls behind the target or stalls appear, the server is saturated.
+ *
+ * With `--ping`, the time sync exchange of time_sync.hpp runs alongside the readings and the report
+ * adds the round trip and the latency from the send of a reading to its injection.
+ *
+ * With `--compact`, every connection offers compact frames (see compact_frame.hpp) in a hello and
+ * sends them if the server accepts, plain readings otherwise.
+ *
+ * With `--transport local`, every connection connects to the Unix domain socket of a server on the
+ * same machine and queues compact frames in the shared-memory ring it gets, see local_ring.hpp.
+ * A full ring counts as a stall, and the report adds how often the server had to be woken up.
+ */
+
+#include "../networking/compact_frame.hpp"
+#include "../networking/histogram.hpp"
+#include "../networking/local_ring.hpp"
+#include "../networking/time_sync.hpp"
+#include "../networking/udp_frame.hpp"
+#include "patterns.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <timeapi.h>
+#endif
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Highest rate per connection, far above any touch screen.
+ */
+constexpr double MAX_RATE = 10000.0;
+
+/**
+ * Unsent bytes a TCP connection may queue before it waits for the server to read.
+ */
+constexpr qint64 MAX_PENDING_BYTES = 64 * 1024;
+
+/**
+ * Sleeping overshoots by up to a timer tick, the end of every wait is spent spinning instead.
+ */
+constexpr auto SPIN_THRESHOLD = std::chrono::microseconds(200);
+
+std::atomic<bool> stopRequested{false};
+
+void requestStop(int)
+{
+	stopRequested.store(true, std::memory_order_relaxed);
+}
+
+struct Options
+{
+	QString host;
+	quint16 port = 0;
+	bool udp = false;
+	bool local = false;
+	QString socketPath; // Of the local transport
+	int connections = 1;
+	double rate = 120.0;
+	int burst = 1;
+	int split = 1;
+	int jitter = 0; // Microseconds
+	Pattern pattern = Pattern::Circle;
+	double duration = 10.0;
+	int pingEvery = 0;
+	bool compact = false;
+};
+
+/**
+ * @brief Counters of one connection, written by its thread and read by the reporting thread.
+ */
+struct ConnectionStats
+{
+	std::atomic<bool> connected{false};
+	std::atomic<bool> failed{false};
+	std::atomic<bool> compact{false};	 // The server accepted compact frames
+	std::atomic<uint64_t> sent{0};		 // Readings
+	std::atomic<uint64_t> bytes{0};		 // Everything written, control frames included
+	std::atomic<uint64_t> stalls{0};	 // Times the connection waited for the server to read
+	std::atomic<uint64_t> sendErrors{0}; // Failed UDP writes, e.g. nothing listening
+	std::atomic<uint64_t> wakeups{0};	 // Local transport, times the server was woken up
+	Histogram lateness;					 // Nanoseconds a send started after its schedule
+	Histogram roundTrip;				 // Nanoseconds, network round trip of the time sync exchanges
+	Histogram sendToInjection;			 // Nanoseconds from the ping to the injection of its reading
+};
+
+void increment(std::atomic<uint64_t> &counter, uint64_t value = 1)
+{
+	// Single writer, see Histogram::record()
+	counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+uint64_t toNanoseconds(Clock::duration duration)
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+}
+
+void waitUntil(Clock::time_point deadline)
+{
+	if (deadline - Clock::now() > SPIN_THRESHOLD)
+		std::this_thread::sleep_until(deadline - SPIN_THRESHOLD);
+	while (Clock::now() < deadline)
+		std::this_thread::yield();
+}
+
+/**
+ * @brief One synthetic client. Construct and run it on its own thread, its socket belongs there.
+ */
+class Connection
+{
+  public:
+	Connection(const Options &options, ConnectionStats &stats, uint32_t index)
+		: m_options(options), m_stats(stats), m_index(index), m_script(options.pattern, index + 1)
+	{
+	}
+
+	void run();
+
+  private:
+	bool connectSocket();
+	void negotiate();
+	bool sendReading(double seconds);
+	bool sendPing();
+	bool write(const char *data, std::size_t len);
+	void readReplies();
+	void receiveControl();
+	void handleControl(const time_sync::Message &message);
+
+	const Options &m_options;
+	ConnectionStats &m_stats;
+	uint32_t m_index;
+	PatternScript m_script;
+	std::unique_ptr<QAbstractSocket> m_socket;
+	std::unique_ptr<local_ring::Producer> m_local; // Instead of m_socket on the local transport
+
+	uint64_t m_readings = 0;
+	uint32_t m_sequence = 0;
+	uint32_t m_nextPing = 1;
+	bool m_compact = false;
+	ClockSync m_clock;
+	QByteArray m_replies; // Received over TCP, a control frame may arrive in pieces
+};
+
+void Connection::run()
+{
+	if (!connectSocket())
+	{
+		m_stats.failed.store(true, std::memory_order_relaxed);
+		return;
+	}
+	m_stats.connected.store(true, std::memory_order_relaxed);
+	if (m_options.compact && !m_local)
+		negotiate();
+
+	// A burst is sent back to back, bursts are spaced so the average rate stays the same
+	const auto interval = std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<double>(m_options.burst / m_options.rate));
+	std::minstd_rand jitterRandom(m_index + 1);
+	const Clock::time_point start = Clock::now();
+	Clock::time_point scheduled = start;
+
+	bool open = true;
+	while (open && !stopRequested.load(std::memory_order_relaxed))
+	{
+		Clock::time_point sendAt = scheduled;
+		if (m_options.jitter > 0)
+		{
+			const auto delay = jitterRandom() % static_cast<unsigned>(m_options.jitter + 1);
+			sendAt += std::chrono::microseconds(delay);
+		}
+		waitUntil(sendAt);
+
+		const Clock::time_point now = Clock::now();
+		m_stats.lateness.record(toNanoseconds(now - sendAt));
+		const double seconds = std::chrono::duration<double>(now - start).count();
+		for (int i = 0; open && i < m_options.burst; i++)
+		{
+			if (m_options.pingEvery > 0 && m_readings % static_cast<uint64_t>(m_options.pingEvery) == 0)
+				open = sendPing();
+			open = open && sendReading(seconds);
+		}
+		readReplies();
+
+		// No catch-up flood after a stall, a rate below the target is what the report is for
+		scheduled = std::max(scheduled + interval, Clock::now() - interval);
+	}
+
+	if (!open)
+	{
+		const QString reason = m_local ? QStringLiteral("closed by the server") : m_socket->errorString();
+		qWarning().noquote() << "Connection" << m_index << "lost:" << reason;
+		m_stats.failed.store(true, std::memory_order_relaxed);
+	}
+	m_stats.connected.store(false, std::memory_order_relaxed);
+	if (m_local)
+	{
+		m_stats.wakeups.store(m_local->wakeupCount(), std::memory_order_relaxed);
+		m_local->close();
+	}
+	else
+		m_socket->close();
+}
+
+bool Connection::connectSocket()
+{
+	if (m_options.local)
+	{
+		m_local = std::make_unique<local_ring::Producer>();
+		QString error;
+		if (!m_local->connect(m_options.socketPath, error))
+		{
+			qWarning().noquote() << "Connection" << m_index << "failed:" << error;
+			return false;
+		}
+		// The ring only carries compact frames
+		m_compact = true;
+		m_stats.compact.store(true, std::memory_order_relaxed);
+		return true;
+	}
+
+	if (m_options.udp)
+	{
+		// Connected, so writes go to the server and only its replies are received
+		m_socket = std::make_unique<QUdpSocket>();
+	}
+	else
+	{
+		m_socket = std::make_unique<QTcpSocket>();
+	}
+	m_socket->connectToHost(m_options.host, m_options.port);
+	if (!m_socket->waitForConnected(3000))
+	{
+		qWarning().noquote() << "Connection" << m_index << "failed:" << m_socket->errorString();
+		return false;
+	}
+	if (!m_options.udp)
+		m_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+	return true;
+}
+
+void Connection::negotiate()
+{
+	time_sync::Message hello;
+	hello.kind = time_sync::Message::Kind::Hello;
+	hello.version = time_sync::PROTOCOL_VERSION;
+	hello.capabilities = time_sync::CAPABILITY_COMPACT_FRAMES;
+	const QByteArray frame = time_sync::encode(hello);
+	if (!write(frame.constData(), static_cast<std::size_t>(frame.size())))
+		return;
+
+	// A server without the handshake never answers, readings stay Colfer then
+	const Clock::time_point deadline = Clock::now() + std::chrono::seconds(1);
+	while (!m_compact && Clock::now() < deadline && !stopRequested.load(std::memory_order_relaxed))
+	{
+		m_socket->waitForReadyRead(100);
+		receiveControl();
+	}
+	if (!m_compact)
+		qWarning() << "Connection" << m_index << "sends Colfer readings, compact frames were not accepted";
+}
+
+bool Connection::sendReading(double seconds)
+{
+	vgp_data_exchange_gamepad_reading reading;
+	uint32_t held = 0;
+	m_script.next(seconds, reading, held);
+
+	udp_frame::Frame frame;
+	frame.sequence = m_sequence++;
+	frame.button_state = held;
+	frame.reading = reading;
+
+	uint8_t buffer[udp_frame::MAX_DATAGRAM_SIZE];
+	const char *data = reinterpret_cast<const char *>(buffer);
+	std::size_t size = 0;
+	if (m_compact)
+		size = compact_frame::encode(frame, buffer);
+	else if (m_options.udp)
+		size = udp_frame::encode(frame, buffer);
+	else
+		size = vgp_data_exchange_gamepad_reading_marshal(&reading, buffer);
+
+	if (m_local)
+	{
+		// A full ring is what a full send buffer is to the sockets, the server does not keep up
+		if (!m_local->push(buffer))
+		{
+			increment(m_stats.stalls);
+			while (!m_local->push(buffer))
+			{
+				if (stopRequested.load(std::memory_order_relaxed))
+					return true; // Not sent, but the run ends anyway
+				std::this_thread::yield();
+			}
+		}
+		increment(m_stats.bytes, size);
+	}
+	else if (m_options.udp)
+	{
+		if (!write(data, size))
+			return false;
+	}
+	else
+	{
+		// Every part is flushed on its own, with Nagle disabled it leaves as a segment of its own
+		const auto parts = std::min(static_cast<std::size_t>(m_options.split), size);
+		std::size_t offset = 0;
+		for (std::size_t part = 1; part <= parts; part++)
+		{
+			const std::size_t end = size * part / parts;
+			if (!write(data + offset, end - offset))
+				return false;
+			offset = end;
+		}
+	}
+
+	m_readings++;
+	increment(m_stats.sent);
+	return true;
+}
+
+bool Connection::sendPing()
+{
+	time_sync::Message ping;
+	ping.kind = time_sync::Message::Kind::Ping;
+	ping.seq = m_nextPing++;
+	ping.t1 = time_sync::now();
+	const QByteArray frame = time_sync::encode(ping);
+	return write(frame.constData(), static_cast<std::size_t>(frame.size()));
+}
+
+bool Connection::write(const char *data, std::size_t len)
+{
+	if (m_local)
+	{
+		if (!m_local->send(data, len))
+			return false;
+		increment(m_stats.bytes, len);
+		return true;
+	}
+
+	const qint64 written = m_socket->write(data, static_cast<qint64>(len));
+	if (m_options.udp)
+	{
+		// One write is one datagram, a refused one does not end the connection
+		if (written < 0)
+			increment(m_stats.sendErrors);
+		else
+			increment(m_stats.bytes, len);
+		return true;
+	}
+
+	if (written != static_cast<qint64>(len))
+		return false;
+	increment(m_stats.bytes, len);
+
+	// There is no event loop on this thread, flush() sends what the kernel accepts without blocking
+	m_socket->flush();
+	if (m_socket->bytesToWrite() > MAX_PENDING_BYTES)
+	{
+		// The server does not keep up, wait instead of queueing without bound
+		increment(m_stats.stalls);
+		while (m_socket->bytesToWrite() > MAX_PENDING_BYTES / 2)
+		{
+			if (!m_socket->waitForBytesWritten(1000))
+				return false;
+		}
+	}
+	return m_socket->state() == QAbstractSocket::ConnectedState;
+}
+
+void Connection::readReplies()
+{
+	if (m_options.pingEvery == 0)
+		return;
+
+	// Without an event loop, a wait with a zero timeout is what moves received data into the socket
+	if (!m_local)
+		m_socket->waitForReadyRead(0);
+	receiveControl();
+}
+
+void Connection::receiveControl()
+{
+	time_sync::Message message;
+	std::size_t consumed = 0;
+	if (m_options.udp)
+	{
+		auto *socket = static_cast<QUdpSocket *>(m_socket.get());
+		char datagram[time_sync::MAX_CONTROL_SIZE];
+		while (socket->hasPendingDatagrams())
+		{
+			const qint64 size = socket->readDatagram(datagram, sizeof(datagram));
+			if (size > 0 &&
+				time_sync::decode(datagram, static_cast<std::size_t>(size), message, consumed) ==
+					time_sync::DecodeResult::Ok)
+			{
+				handleControl(message);
+			}
+		}
+		return;
+	}
+
+	m_replies.append(m_local ? m_local->receive() : m_socket->readAll());
+	while (!m_replies.isEmpty())
+	{
+		auto decoded = time_sync::decode(m_replies.constData(),
+										 static_cast<std::size_t>(m_replies.size()),
+										 message,
+										 consumed);
+		if (decoded == time_sync::DecodeResult::Incomplete)
+			break;
+		if (decoded == time_sync::DecodeResult::Ok)
+			handleControl(message);
+		m_replies.remove(0, static_cast<qsizetype>(std::max<std::size_t>(consumed, 1)));
+	}
+}
+
+void Connection::handleControl(const time_sync::Message &message)
+{
+	if (message.kind == time_sync::Message::Kind::Welcome)
+	{
+		m_compact = (message.capabilities & time_sync::CAPABILITY_COMPACT_FRAMES) != 0;
+		m_stats.compact.store(m_compact, std::memory_order_relaxed);
+		return;
+	}
+	if (message.kind != time_sync::Message::Kind::Pong)
+		return;
+
+	const int64_t t4 = time_sync::now();
+	m_clock.addExchange(message.t1, message.t2, message.t3, t4);
+	const int64_t roundTrip = (t4 - message.t1) - (message.t3 - message.t2);
+	if (roundTrip >= 0)
+		m_stats.roundTrip.record(static_cast<uint64_t>(roundTrip) * 1000);
+	// Same estimate as the server's, with the best offset known so far
+	const int64_t latency = message.ti - m_clock.toServerTime(message.t1);
+	if (latency >= 0)
+		m_stats.sendToInjection.record(static_cast<uint64_t>(latency) * 1000);
+
+	time_sync::Message done;
+	done.kind = time_sync::Message::Kind::Done;
+	done.seq = message.seq;
+	done.t4 = t4;
+	const QByteArray frame = time_sync::encode(done);
+	write(frame.constData(), static_cast<std::size_t>(frame.size()));
+}
+
+/**
+ * @brief Reads the options. @return false if one is invalid, the error has been printed.
+ */
+bool parseOptions(const QCommandLineParser &parser, Options &options)
+{
+	options.host = parser.value("host");
+
+	const QString transport = parser.value("transport").toLower();
+	if (transport != "tcp" && transport != "udp" && transport != "local")
+	{
+		qCritical() << "Invalid transport:" << transport << "(expected tcp, udp or local)";
+		return false;
+	}
+	options.udp = transport == "udp";
+	options.local = transport == "local";
+
+	bool ok = false;
+	if (options.local)
+	{
+		options.socketPath = parser.value("socket");
+		if (options.socketPath.isEmpty())
+		{
+			qCritical() << "The local transport requires --socket";
+			return false;
+		}
+	}
+	else
+	{
+		const uint port = parser.value("port").toUInt(&ok);
+		if (!ok || port == 0 || port > 65535)
+		{
+			qCritical() << "A valid --port is required";
+			return false;
+		}
+		options.port = static_cast<quint16>(port);
+	}
+	options.compact = parser.isSet("compact");
+
+	auto integer = [&parser](const QString &name, int minimum, int &value)
+	{
+		bool parsed = false;
+		value = parser.value(name).toInt(&parsed);
+		if (!parsed || value < minimum)
+		{
+			qCritical() << "Invalid" << name << parser.value(name);
+			return false;
+		}
+		return true;
+	};
+	if (!integer("connections", 1, options.connections) || !integer("burst", 1, options.burst) ||
+		!integer("split", 1, options.split) || !integer("jitter", 0, options.jitter) ||
+		!integer("ping", 0, options.pingEvery))
+	{
+		return false;
+	}
+
+	options.rate = parser.value("rate").toDouble(&ok);
+	if (!ok || options.rate <= 0.0 || options.rate > MAX_RATE)
+	{
+		qCritical() << "The rate must be above 0 and at most" << MAX_RATE << "Hz";
+		return false;
+	}
+
+	options.duration = parser.value("duration").toDouble(&ok);
+	if (!ok || options.duration <= 0.0)
+	{
+		qCritical() << "Invalid duration:" << parser.value("duration");
+		return false;
+	}
+
+	if (!parsePattern(parser.value("pattern"), options.pattern))
+	{
+		qCritical() << "Invalid pattern:" << parser.value("pattern");
+		return false;
+	}
+
+	if ((options.udp || options.local) && options.split > 1)
+		qWarning() << "--split only applies to TCP, every datagram or frame carries a complete reading";
+	return true;
+}
+
+/**
+ * @brief Largest percentile among the connections, the one a player on the worst connection sees.
+ */
+uint64_t worstPercentile(const std::vector<std::unique_ptr<ConnectionStats>> &stats,
+						 Histogram ConnectionStats::*histogram,
+						 double percentile)
+{
+	uint64_t worst = 0;
+	for (const auto &connection : stats)
+		worst = std::max(worst, ((*connection).*histogram).percentile(percentile));
+	return worst;
+}
+
+void printSummary(const Options &options,
+				  const std::vector<std::unique_ptr<ConnectionStats>> &stats,
+				  double elapsed)
+{
+	uint64_t sent = 0;
+	uint64_t bytes = 0;
+	uint64_t stalls = 0;
+	uint64_t sendErrors = 0;
+	std::size_t failed = 0;
+	std::size_t compact = 0;
+	for (const auto &connection : stats)
+	{
+		compact += connection->compact.load(std::memory_order_relaxed) ? 1 : 0;
+		sent += connection->sent.load(std::memory_order_relaxed);
+		bytes += connection->bytes.load(std::memory_order_relaxed);
+		stalls += connection->stalls.load(std::memory_order_relaxed);
+		sendErrors += connection->sendErrors.load(std::memory_order_relaxed);
+		failed += connection->failed.load(std::memory_order_relaxed) ? 1 : 0;
+	}
+
+	const double target = options.rate * static_cast<double>(options.connections);
+	const double achieved = static_cast<double>(sent) / elapsed;
+	std::printf("total: %.1f s, %llu readings, %.0f readings/s of %.0f targeted (%.1f%%), %.1f KiB/s\n",
+				elapsed,
+				static_cast<unsigned long long>(sent),
+				achieved,
+				target,
+				100.0 * achieved / target,
+				static_cast<double>(bytes) / 1024.0 / elapsed);
+	std::printf("connections failed=%zu stalls=%llu send_errors=%llu late_p50/p99/max_us=%.1f/%.1f/%.1f\n",
+				failed,
+				static_cast<unsigned long long>(stalls),
+				static_cast<unsigned long long>(sendErrors),
+				static_cast<double>(worstPercentile(stats, &ConnectionStats::lateness, 50.0)) / 1000.0,
+				static_cast<double>(worstPercentile(stats, &ConnectionStats::lateness, 99.0)) / 1000.0,
+				static_cast<double>(worstPercentile(stats, &ConnectionStats::lateness, 100.0)) / 1000.0);
+	if (options.compact)
+		std::printf("compact_frames=%zu of %zu connections\n", compact, stats.size());
+	if (options.local)
+	{
+		uint64_t wakeups = 0;
+		for (const auto &connection : stats)
+			wakeups += connection->wakeups.load(std::memory_order_relaxed);
+		std::printf("server_wakeups=%llu readings_per_wakeup=%.1f\n",
+					static_cast<unsigned long long>(wakeups),
+					wakeups > 0 ? static_cast<double>(sent) / static_cast<double>(wakeups) : 0.0);
+	}
+	if (options.pingEvery > 0)
+	{
+		std::printf("round_trip_p50/p99_us=%.1f/%.1f send_to_injection_p50/p99_us=%.1f/%.1f\n",
+					static_cast<double>(worstPercentile(stats, &ConnectionStats::roundTrip, 50.0)) / 1000.0,
+					static_cast<double>(worstPercentile(stats, &ConnectionStats::roundTrip, 99.0)) / 1000.0,
+					static_cast<double>(worstPercentile(stats, &ConnectionStats::sendToInjection, 50.0)) /
+						1000.0,
+					static_cast<double>(worstPercentile(stats, &ConnectionStats::sendToInjection, 99.0)) /
+						1000.0);
+	}
+	std::fflush(stdout);
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("vgp-loadgen");
+	QCoreApplication::setApplicationVersion(APP_VERSION);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Synthetic VirtualGamePad clients for stress-testing a server");
+	parser.addHelpOption();
+	parser.addVersionOption();
+	parser.addOptions({
+		{{"H", "host"}, "Server address.", "host", "127.0.0.1"},
+		{{"p", "port"}, "Server port.", "port"},
+		{{"t", "transport"}, "tcp, udp or local.", "transport", "tcp"},
+		{"socket", "Unix domain socket of the server, for the local transport.", "path"},
+		{{"c", "connections"}, "Number of parallel connections.", "n", "1"},
+		{{"r", "rate"}, "Readings per second on each connection, up to 10000.", "hz", "120"},
+		{{"b", "burst"}, "Readings sent back to back, the average rate stays the same.", "n", "1"},
+		{"split", "TCP only, sends every reading in this many segments.", "n", "1"},
+		{"jitter", "Delays every send by up to this many microseconds, at random.", "us", "0"},
+		{"pattern", "idle, circle, sweep, buttons or mash.", "pattern", "circle"},
+		{{"d", "duration"}, "Seconds to run, Ctrl+C stops earlier.", "seconds", "10"},
+		{"ping", "Measures the latency with a time sync ping every n readings, 0 for none.", "n", "0"},
+		{"compact", "Negotiates compact frames, plain readings if the server refuses."},
+	});
+	parser.process(app);
+
+	Options options;
+	if (!parseOptions(parser, options))
+		return 2;
+
+	std::signal(SIGINT, requestStop);
+	std::signal(SIGTERM, requestStop);
+#ifdef _WIN32
+	// The default timer resolution of 15.6 ms would make every rate above 64 Hz bursty
+	timeBeginPeriod(1);
+#endif
+
+	std::vector<std::unique_ptr<ConnectionStats>> stats;
+	std::vector<std::thread> threads;
+	for (int i = 0; i < options.connections; i++)
+	{
+		stats.push_back(std::make_unique<ConnectionStats>());
+		threads.emplace_back(
+			[&options, connection = stats.back().get(), i]()
+			{
+				Connection(options, *connection, static_cast<uint32_t>(i)).run();
+			});
+	}
+
+	const Clock::time_point start = Clock::now();
+	const auto runTime =
+		std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+	const Clock::time_point end = start + runTime;
+	Clock::time_point nextReport = start + std::chrono::seconds(1);
+	uint64_t lastSent = 0;
+	uint64_t lastBytes = 0;
+	while (!stopRequested.load(std::memory_order_relaxed) && Clock::now() < end)
+	{
+		// Short sleeps, so Ctrl+C is noticed quickly
+		std::this_thread::sleep_until(
+			std::min({nextReport, end, Clock::now() + std::chrono::milliseconds(100)}));
+		if (Clock::now() < nextReport)
+			continue;
+		nextReport += std::chrono::seconds(1);
+
+		uint64_t sent = 0;
+		uint64_t bytes = 0;
+		uint64_t stalls = 0;
+		int connected = 0;
+		for (const auto &connection : stats)
+		{
+			sent += connection->sent.load(std::memory_order_relaxed);
+			bytes += connection->bytes.load(std::memory_order_relaxed);
+			stalls += connection->stalls.load(std::memory_order_relaxed);
+			connected += connection->connected.load(std::memory_order_relaxed) ? 1 : 0;
+		}
+		std::printf("%6.1f s connected=%d/%d rate=%llu/s throughput=%.1f KiB/s stalls=%llu "
+					"late_p99_us=%.1f\n",
+					std::chrono::duration<double>(Clock::now() - start).count(),
+					connected,
+					options.connections,
+					static_cast<unsigned long long>(sent - lastSent),
+					static_cast<double>(bytes - lastBytes) / 1024.0,
+					static_cast<unsigned long long>(stalls),
+					static_cast<double>(worstPercentile(stats, &ConnectionStats::lateness, 99.0)) / 1000.0);
+		std::fflush(stdout);
+		lastSent = sent;
+		lastBytes = bytes;
+	}
+
+	stopRequested.store(true, std::memory_order_relaxed);
+	for (std::thread &thread : threads)
+		thread.join();
+	printSummary(options, stats, std::chrono::duration<double>(Clock::now() - start).count());
+
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+
+	const bool allFailed = std::all_of(stats.begin(),
+									   stats.end(),
+									   [](const std::unique_ptr<ConnectionStats> &connection)
+									   {
+										   return connection->failed.load(std::memory_order_relaxed) &&
+												  connection->sent.load(std::memory_order_relaxed) == 0;
+									   });
+	return allFailed ? 1 : 0;
+}
@@ -1,4 +1,5 @@
 #include "appdir.hpp"
+#include "networking/device_pool.hpp"
 #include "platform/windows/console.hpp"
 #include "ui/mainwindow.hpp"
 
@@ -114,6 +115,7 @@ int main(int argc, char *argv[])
 	w.show();
 	qInfo() << "Application initialized successfully. Version:" << QApplication::applicationVersion();
 	int result = QApplication::exec();
+	DevicePool::instance().close(); // The devices of sessions still open go when their window does
 	qInfo() << "Application shutting down with exit code:" << result;
 
 	if (logFileOpened)
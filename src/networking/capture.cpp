@@ -0,0 +1,182 @@
+#include "capture.hpp"
+
+#include <QDebug>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+constexpr std::size_t paddedLength(std::size_t length)
+{
+	return (length + 7) & ~std::size_t{7};
+}
+} // namespace
+
+CaptureWriter::~CaptureWriter()
+{
+	close();
+}
+
+bool CaptureWriter::open(const QString &path)
+{
+	close();
+	m_file.setFileName(path);
+	if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+		return false;
+
+	m_used = static_cast<qint64>(sizeof(capture::FileHeader));
+	if (!grow(GROW_SIZE))
+	{
+		m_file.close();
+		return false;
+	}
+
+	capture::FileHeader header{};
+	std::memcpy(header.magic, capture::MAGIC, sizeof(header.magic));
+	header.version = capture::VERSION;
+	header.used = static_cast<uint64_t>(m_used);
+	std::memcpy(m_map, &header, sizeof(header));
+
+	m_start = Clock::now();
+	qInfo() << "Capturing received data to" << path;
+	return true;
+}
+
+void CaptureWriter::close()
+{
+	if (!m_file.isOpen())
+		return;
+	if (m_map != nullptr)
+	{
+		m_file.unmap(m_map);
+		m_map = nullptr;
+	}
+	// Drop the unused tail of the last growth step
+	m_file.resize(m_used);
+	m_file.close();
+	m_mapped = 0;
+}
+
+bool CaptureWriter::grow(qint64 size)
+{
+	if (m_map != nullptr)
+	{
+		m_file.unmap(m_map);
+		m_map = nullptr;
+	}
+	if (!m_file.resize(size))
+		return false;
+	m_map = m_file.map(0, size);
+	if (m_map == nullptr)
+		return false;
+	m_mapped = size;
+	return true;
+}
+
+void CaptureWriter::append(uint64_t session,
+						   capture::RecordKind kind,
+						   Clock::time_point arrival,
+						   const char *data,
+						   std::size_t length)
+{
+	if (m_map == nullptr) [[unlikely]]
+		return;
+
+	const auto recordSize = static_cast<qint64>(sizeof(capture::RecordHeader) + paddedLength(length));
+	if (m_used + recordSize > m_mapped) [[unlikely]]
+	{
+		if (!grow(std::max(m_mapped + GROW_SIZE, m_used + recordSize)))
+		{
+			qWarning() << "Capture file cannot grow, capturing stopped:" << m_file.errorString();
+			close();
+			return;
+		}
+	}
+
+	capture::RecordHeader header{};
+	header.time = std::chrono::duration_cast<std::chrono::nanoseconds>(arrival - m_start).count();
+	header.session = session;
+	header.length = static_cast<uint32_t>(length);
+	header.kind = static_cast<uint16_t>(kind);
+
+	uchar *target = m_map + m_used;
+	std::memcpy(target, &header, sizeof(header));
+	std::memcpy(target + sizeof(header), data, length);
+	m_used += recordSize;
+
+	// Last, a reader never sees a record that is not completely written
+	const auto used = static_cast<uint64_t>(m_used);
+	std::memcpy(m_map + offsetof(capture::FileHeader, used), &used, sizeof(used));
+}
+
+CaptureReader::~CaptureReader()
+{
+	if (m_map != nullptr)
+		m_file.unmap(const_cast<uchar *>(m_map));
+}
+
+bool CaptureReader::open(const QString &path)
+{
+	m_file.setFileName(path);
+	if (!m_file.open(QIODevice::ReadOnly))
+	{
+		m_error = m_file.errorString();
+		return false;
+	}
+
+	const qint64 size = m_file.size();
+	if (size < static_cast<qint64>(sizeof(capture::FileHeader)))
+	{
+		m_error = QStringLiteral("Not a capture file");
+		return false;
+	}
+	m_map = m_file.map(0, size);
+	if (m_map == nullptr)
+	{
+		m_error = m_file.errorString();
+		return false;
+	}
+
+	capture::FileHeader header;
+	std::memcpy(&header, m_map, sizeof(header));
+	if (std::memcmp(header.magic, capture::MAGIC, sizeof(header.magic)) != 0)
+	{
+		m_error = QStringLiteral("Not a capture file");
+		return false;
+	}
+	if (header.version != capture::VERSION)
+	{
+		m_error = QStringLiteral("Unsupported capture version %1").arg(header.version);
+		return false;
+	}
+	// A writer that crashed leaves the file longer than `used`, never shorter
+	m_used = static_cast<std::size_t>(std::min<uint64_t>(header.used, static_cast<uint64_t>(size)));
+	rewind();
+	return true;
+}
+
+bool CaptureReader::next(capture::Record &record)
+{
+	if (m_map == nullptr || m_position + sizeof(capture::RecordHeader) > m_used)
+		return false;
+
+	capture::RecordHeader header;
+	std::memcpy(&header, m_map + m_position, sizeof(header));
+	const std::size_t end = m_position + sizeof(header) + paddedLength(header.length);
+	if (end > m_used) [[unlikely]]
+		return false;
+
+	record.time = std::chrono::nanoseconds(header.time);
+	record.session = header.session;
+	record.kind = static_cast<capture::RecordKind>(header.kind);
+	record.data = reinterpret_cast<const char *>(m_map + m_position + sizeof(header));
+	record.length = header.length;
+	m_position = end;
+	return true;
+}
+
+void CaptureReader::rewind()
+{
+	m_position = sizeof(capture::FileHeader);
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file capture.hpp
+ * @brief Binary capture of the bytes received from clients, for offline replay.
+ *
+ * @details
+ * A capture file is a FileHeader followed by records, each a RecordHeader and the received bytes,
+ * padded to a multiple of 8 bytes. Integers are in the byte order of the machine that captured.
+ *
+ * | Field                  | Size | Contents                                                    |
+ * |------------------------|------|-------------------------------------------------------------|
+ * | FileHeader::magic      | 8    | `VGPCAP` followed by two zero bytes                         |
+ * | FileHeader::version    | 4    | VERSION                                                     |
+ * | FileHeader::reserved   | 4    | 0                                                           |
+ * | FileHeader::used       | 8    | Bytes of the file holding complete records, header included |
+ * | RecordHeader::time     | 8    | Arrival, nanoseconds on the monotonic clock since the start |
+ * | RecordHeader::session  | 8    | Session id, records of several clients are interleaved      |
+ * | RecordHeader::length   | 4    | Number of bytes that follow                                 |
+ * | RecordHeader::kind     | 2    | RecordKind                                                  |
+ * | RecordHeader::reserved | 2    | 0                                                           |
+ *
+ * Stream records are whatever one read returned, so readings may be split across records.
+ * Datagram records are exactly one datagram. Frames records are the compact frames taken from
+ * a shared-memory ring at once, back to back (see local_ring.hpp).
+ *
+ * The file is written through a memory mapping that grows in GROW_SIZE steps, so capturing costs
+ * a copy per receive instead of a system call. `used` is updated after every record, a capture
+ * cut short by a crash is readable up to its last complete record.
+ */
+namespace capture
+{
+constexpr char MAGIC[8] = {'V', 'G', 'P', 'C', 'A', 'P', '\0', '\0'};
+constexpr uint32_t VERSION = 1;
+
+enum class RecordKind : uint16_t
+{
+	Stream = 1,
+	Datagram = 2,
+	Frames = 3
+};
+
+struct FileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t used;
+};
+
+struct RecordHeader
+{
+	int64_t time;
+	uint64_t session;
+	uint32_t length;
+	uint16_t kind;
+	uint16_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 24 && sizeof(RecordHeader) == 24);
+
+/**
+ * @brief A record as read back, @p data points into the mapped file.
+ */
+struct Record
+{
+	std::chrono::nanoseconds time;
+	uint64_t session;
+	RecordKind kind;
+	const char *data;
+	std::size_t length;
+};
+} // namespace capture
+
+/**
+ * @brief Appends records to a capture file. Not thread-safe, owned by the network thread.
+ */
+class CaptureWriter
+{
+  public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr qint64 GROW_SIZE = 1 << 20;
+
+	CaptureWriter() = default;
+	~CaptureWriter();
+
+	// Delete copy and move operations, the mapping belongs to the file
+	CaptureWriter(const CaptureWriter &) = delete;
+	CaptureWriter &operator=(const CaptureWriter &) = delete;
+	CaptureWriter(CaptureWriter &&) = delete;
+	CaptureWriter &operator=(CaptureWriter &&) = delete;
+
+	/**
+	 * @brief Creates (or truncates) the capture file. Record times are relative to this call.
+	 */
+	bool open(const QString &path);
+
+	/**
+	 * @brief Trims the file to the records written and closes it.
+	 */
+	void close();
+
+	bool isOpen() const
+	{
+		return m_map != nullptr;
+	}
+
+	QString errorString() const
+	{
+		return m_file.errorString();
+	}
+
+	/**
+	 * @brief Appends one record. Stops capturing (with a warning) if the file cannot grow.
+	 */
+	void append(uint64_t session,
+				capture::RecordKind kind,
+				Clock::time_point arrival,
+				const char *data,
+				std::size_t length);
+
+  private:
+	bool grow(qint64 size);
+
+	QFile m_file;
+	uchar *m_map = nullptr;
+	qint64 m_mapped = 0;
+	qint64 m_used = 0;
+	Clock::time_point m_start;
+};
+
+/**
+ * @brief Reads the records of a capture file, in the order they were written.
+ */
+class CaptureReader
+{
+  public:
+	CaptureReader() = default;
+	~CaptureReader();
+
+	// Delete copy and move operations, records point into the mapping
+	CaptureReader(const CaptureReader &) = delete;
+	CaptureReader &operator=(const CaptureReader &) = delete;
+	CaptureReader(CaptureReader &&) = delete;
+	CaptureReader &operator=(CaptureReader &&) = delete;
+
+	/**
+	 * @brief Maps the file. @return false if it cannot be mapped or is not a capture, see errorString().
+	 */
+	bool open(const QString &path);
+
+	const QString &errorString() const
+	{
+		return m_error;
+	}
+
+	/**
+	 * @brief Reads the next record. @return false at the end of the capture.
+	 */
+	bool next(capture::Record &record);
+
+	/**
+	 * @brief Goes back to the first record.
+	 */
+	void rewind();
+
+  private:
+	QFile m_file;
+	const uchar *m_map = nullptr;
+	std::size_t m_used = 0;
+	std::size_t m_position = 0;
+	QString m_error;
+};
@@ -0,0 +1,457 @@
+#include "client_session.hpp"
+
+#include <QDebug>
+#include <algorithm>
+#include <span>
+#include <utility>
+
+namespace
+{
+uint64_t elapsedNanoseconds(std::chrono::steady_clock::time_point since)
+{
+	const auto elapsed = std::chrono::steady_clock::now() - since;
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+} // namespace
+
+ClientSession::ClientSession(quint64 id,
+							 const QString &description,
+							 std::unique_ptr<ExecutorInterface> executor,
+							 int injectionRate,
+							 const low_latency::Options &lowLatency)
+	: m_id(id), m_description(description), m_injector(std::move(executor), injectionRate, lowLatency)
+{
+	m_lastReceive.start();
+	m_injector.start();
+}
+
+ClientSession::~ClientSession()
+{
+	// The client is gone, whatever it held must not stay pressed. stop() injects what is queued.
+	if (m_heldButtons != 0 || m_analogActive)
+		m_injector.submit(release_reading());
+	m_injector.stop();
+	const SessionStats stats = snapshot();
+	qInfo() << "Session" << m_id << "closed. Average Request Interval" << stats.averageRequestInterval
+			<< "ms, Request Count:" << stats.requestCount;
+	qInfo() << "Inter-arrival p50/p99/p99.9/max (us):" << stats.interArrivalTime.p50 / 1000
+			<< stats.interArrivalTime.p99 / 1000 << stats.interArrivalTime.p999 / 1000
+			<< stats.interArrivalTime.max / 1000;
+	qInfo() << "Injection p50/p99/p99.9/max (us):" << stats.injectTime.p50 / 1000
+			<< stats.injectTime.p99 / 1000 << stats.injectTime.p999 / 1000 << stats.injectTime.max / 1000;
+}
+
+bool ClientSession::readStream(QIODevice *device)
+{
+#ifdef QT_DEBUG
+	qDebug() << "Session" << m_id << "received: " << device->bytesAvailable() << "bytes";
+#endif
+
+	markReceived();
+	const Clock::time_point arrival = Clock::now();
+	flushEchoes();
+
+	// A burst larger than the buffer is handled in several rounds
+	while (device->bytesAvailable() > 0)
+	{
+		if (m_dataBuffer.writable() == 0)
+		{
+			qWarning() << "Session" << m_id << "filled the receive buffer without a complete reading";
+			m_stats.parseErrors++;
+			m_dataBuffer.clear();
+			return false;
+		}
+
+		// Read straight into the buffer, no temporary QByteArray
+		char *target = m_dataBuffer.writePtr();
+		qint64 received = device->read(target, static_cast<qint64>(m_dataBuffer.writable()));
+		if (received <= 0)
+			break;
+		if (m_capture != nullptr)
+		{
+			m_capture->append(m_id,
+							  capture::RecordKind::Stream,
+							  arrival,
+							  target,
+							  static_cast<std::size_t>(received));
+		}
+		m_dataBuffer.commit(static_cast<std::size_t>(received));
+		m_stats.bytesReceived += static_cast<uint64_t>(received);
+
+		parseBuffered(arrival);
+	}
+	return true;
+}
+
+bool ClientSession::receiveStream(const char *data, std::size_t len)
+{
+	markReceived();
+	const Clock::time_point arrival = Clock::now();
+	flushEchoes();
+	if (m_capture != nullptr)
+		m_capture->append(m_id, capture::RecordKind::Stream, arrival, data, len);
+
+	while (len > 0)
+	{
+		if (m_dataBuffer.writable() == 0)
+		{
+			qWarning() << "Session" << m_id << "filled the receive buffer without a complete reading";
+			m_stats.parseErrors++;
+			m_dataBuffer.clear();
+			return false;
+		}
+		const std::size_t chunk = std::min(len, m_dataBuffer.writable());
+		std::copy_n(data, chunk, m_dataBuffer.writePtr());
+		m_dataBuffer.commit(chunk);
+		m_stats.bytesReceived += chunk;
+		data += chunk;
+		len -= chunk;
+		parseBuffered(arrival);
+	}
+	return true;
+}
+
+void ClientSession::parseBuffered(Clock::time_point arrival)
+{
+	// Process as many complete packets as we have in the buffer
+	while (!m_dataBuffer.empty())
+	{
+		if (static_cast<uint8_t>(m_dataBuffer.data()[0]) == time_sync::CONTROL_BYTE)
+		{
+			time_sync::Message message;
+			std::size_t consumed = 0;
+			auto decoded = time_sync::decode(m_dataBuffer.data(), m_dataBuffer.size(), message, consumed);
+			if (decoded == time_sync::DecodeResult::Incomplete)
+				break; // Wait for more data
+			if (decoded == time_sync::DecodeResult::Ok)
+				handleControl(message);
+			else
+				m_stats.parseErrors++;
+			m_dataBuffer.consume(consumed);
+			continue;
+		}
+
+		if (static_cast<uint8_t>(m_dataBuffer.data()[0]) == compact_frame::MARKER)
+		{
+			if (m_dataBuffer.size() < compact_frame::FRAME_SIZE)
+				break; // Wait for more data
+			if (!receiveCompact(reinterpret_cast<const uint8_t *>(m_dataBuffer.data()), arrival))
+			{
+				qWarning() << "Session" << m_id << "sent a malformed or unnegotiated compact frame";
+				m_stats.parseErrors++;
+				m_dataBuffer.clear();
+				break;
+			}
+			m_dataBuffer.consume(compact_frame::FRAME_SIZE);
+			continue;
+		}
+
+		// Every complete reading in the buffer at once, then deliver them in order
+		const Clock::time_point parseStart = Clock::now();
+		const BatchParseResult batch = parse_gamepad_states(
+			std::as_bytes(std::span(m_dataBuffer.data(), m_dataBuffer.size())), m_batch);
+		if (batch.count > 0)
+			m_parseTime.record(elapsedNanoseconds(parseStart) / batch.count);
+
+		for (std::size_t i = 0; i < batch.count; i++)
+			deliverReading(m_batch[i], arrival);
+
+		// Only moves a cursor, the bytes stay where they are
+		m_dataBuffer.consume(batch.bytes_consumed);
+
+#ifdef QT_DEBUG
+		qDebug() << "Consumed" << batch.count << "readings," << batch.bytes_consumed
+				 << "bytes, remaining buffer size:" << m_dataBuffer.size();
+#endif
+
+		using enum BatchParseResult::Stop;
+		if (batch.stop == IncompleteData) [[likely]]
+			break; // Wait for more data
+		if (batch.stop == SchemaMismatch)
+		{
+			qWarning() << "Schema mismatch detected in client data";
+			m_stats.parseErrors++;
+			// The stream has no framing to resynchronise on, drop what we have
+			m_dataBuffer.clear();
+			break;
+		}
+		if (batch.stop == DataTooLarge)
+		{
+			qWarning() << "Client sent data that is too large to process";
+			m_stats.parseErrors++;
+			m_dataBuffer.clear();
+			break;
+		}
+		// End of the data, another kind of frame or more readings than m_batch holds: go on
+	}
+
+	// At most one partial reading is left, move it to the front
+	m_dataBuffer.compact();
+}
+
+void ClientSession::receiveDatagram(const uint8_t *data, std::size_t len)
+{
+	markReceived();
+	m_stats.bytesReceived += len;
+	const Clock::time_point arrival = Clock::now();
+	if (m_capture != nullptr)
+	{
+		m_capture->append(m_id,
+						  capture::RecordKind::Datagram,
+						  arrival,
+						  reinterpret_cast<const char *>(data),
+						  len);
+	}
+	flushEchoes();
+
+	if (len > 0 && data[0] == time_sync::CONTROL_BYTE)
+	{
+		time_sync::Message message;
+		std::size_t consumed = 0;
+		auto decoded = time_sync::decode(reinterpret_cast<const char *>(data), len, message, consumed);
+		if (decoded == time_sync::DecodeResult::Ok && consumed == len)
+			handleControl(message);
+		else
+			m_stats.parseErrors++;
+		return;
+	}
+
+	if (len == compact_frame::FRAME_SIZE && data[0] == compact_frame::MARKER)
+	{
+		if (!receiveCompact(data, arrival))
+			m_stats.parseErrors++;
+		return;
+	}
+
+	udp_frame::Frame frame;
+	const bool decoded = udp_frame::decode(data, len, frame);
+	m_parseTime.record(elapsedNanoseconds(arrival));
+	if (!decoded)
+	{
+		m_stats.parseErrors++;
+		return;
+	}
+	if (!m_sequencer.accept(frame))
+		return; // Stale or duplicate, a newer state was already injected
+
+	deliverReading(frame.reading, arrival);
+}
+
+void ClientSession::receiveFrames(const uint8_t *frames, std::size_t count)
+{
+	markReceived();
+	const Clock::time_point arrival = Clock::now();
+	flushEchoes();
+	m_stats.bytesReceived += count * compact_frame::FRAME_SIZE;
+	if (m_capture != nullptr)
+	{
+		m_capture->append(m_id,
+						  capture::RecordKind::Frames,
+						  arrival,
+						  reinterpret_cast<const char *>(frames),
+						  count * compact_frame::FRAME_SIZE);
+	}
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		if (!deliverCompact(frames + i * compact_frame::FRAME_SIZE, arrival))
+			m_stats.parseErrors++;
+	}
+}
+
+bool ClientSession::receiveCompact(const uint8_t *data, Clock::time_point arrival)
+{
+	return m_compactFrames && deliverCompact(data, arrival);
+}
+
+bool ClientSession::deliverCompact(const uint8_t *data, Clock::time_point arrival)
+{
+	const Clock::time_point parseStart = Clock::now();
+	udp_frame::Frame frame;
+	const bool decoded = compact_frame::decode(data, frame);
+	m_parseTime.record(elapsedNanoseconds(parseStart));
+	if (!decoded)
+		return false;
+
+	frame.sequence = compact_frame::extendSequence(static_cast<uint16_t>(frame.sequence),
+												   m_sequencer.lastSequence());
+	if (m_sequencer.accept(frame))
+		deliverReading(frame.reading, arrival);
+	return true;
+}
+
+void ClientSession::checkStall()
+{
+	// Readings held back while the injection queue was full must not wait for the client's next one
+	m_injector.flushOverflow();
+
+	const qint64 timeout =
+		m_heartbeat ? time_sync::HEARTBEAT_INTERVAL_MS * time_sync::HEARTBEAT_MISSES : m_stallTimeout;
+	if (timeout <= 0 || m_stalled || (m_heldButtons == 0 && !m_analogActive))
+		return;
+	const qint64 idle = m_lastReceive.elapsed();
+	if (idle < timeout)
+		return;
+
+	// One injection releases everything, queued behind what the client sent last
+	m_injector.submit(release_reading());
+	m_stalled = true;
+	m_stallStart = Clock::now();
+	m_heldButtons = 0;
+	m_analogActive = false;
+	// Absolute button states press what is still held once the client is back
+	m_sequencer.releaseButtons();
+	m_stats.stallCount++;
+	qWarning() << "Session" << m_id << "silent for" << idle << "ms, released its inputs";
+}
+
+void ClientSession::markReceived()
+{
+	m_lastReceive.restart();
+	if (m_stalled) [[unlikely]]
+	{
+		m_stalled = false;
+		m_stallDuration.record(elapsedNanoseconds(m_stallStart));
+		qInfo() << "Session" << m_id << "resumed";
+	}
+}
+
+qint64 ClientSession::idleTime() const
+{
+	return m_lastReceive.elapsed();
+}
+
+SessionStats ClientSession::snapshot() const
+{
+	SessionStats stats = m_stats;
+	stats.averageRequestInterval = m_interArrivalTime.mean() / 1e6;
+	stats.interArrivalTime = m_interArrivalTime.summary();
+	stats.parseTime = m_parseTime.summary();
+	stats.injectTime = m_injector.injectTime().summary();
+	stats.queueDepthPercentiles = m_injector.queueDepthHistogram().summary();
+	stats.endToEndLatency = m_endToEndLatency.summary();
+	if (m_clock.synced())
+	{
+		stats.clockOffset = static_cast<double>(m_clock.offset()) / 1000.0;
+		stats.roundTrip = static_cast<double>(m_clock.roundTrip()) / 1000.0;
+	}
+	stats.injectedCount = m_injector.injectedCount();
+	stats.droppedCount = m_injector.droppedCount();
+	stats.collapsedCount = m_injector.collapsedCount();
+	stats.queueDepth = m_injector.queueDepth();
+	stats.playoutDelay = static_cast<double>(m_injector.playoutDelay().count()) / 1000.0;
+	stats.stallDuration = m_stallDuration.summary();
+	stats.staleCount = m_sequencer.staleCount();
+	stats.lostCount = m_sequencer.lostCount();
+	return stats;
+}
+
+void ClientSession::deliverReading(const vgp_data_exchange_gamepad_reading &reading,
+								   Clock::time_point arrival)
+{
+	m_stats.requestCount++;
+	if (m_hasArrival)
+	{
+		m_interArrivalTime.record(static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(arrival - m_lastArrival).count()));
+	}
+	m_lastArrival = arrival;
+	m_hasArrival = true;
+
+	// What the watchdog would have to release. Every reading submitted is injected in order, even when
+	// the queue is full, so this matches what the executor holds once the queue is drained.
+	m_heldButtons = (m_heldButtons | reading.buttons_down) & ~reading.buttons_up;
+	m_analogActive = reading.left_trigger != 0.0f || reading.right_trigger != 0.0f ||
+					 reading.left_thumbstick_x != 0.0f || reading.left_thumbstick_y != 0.0f ||
+					 reading.right_thumbstick_x != 0.0f || reading.right_thumbstick_y != 0.0f;
+
+	// Hand over to the injection thread
+	m_injector.submit(reading, std::exchange(m_stampNext, 0));
+}
+
+void ClientSession::handleControl(const time_sync::Message &message)
+{
+	switch (message.kind)
+	{
+	case time_sync::Message::Kind::Ping:
+	{
+		// The reading that follows the ping carries the probe
+		PendingPing &ping = m_pings[m_nextPing];
+		m_nextPing = (m_nextPing + 1) % m_pings.size();
+		if (m_nextProbe == 0)
+			m_nextProbe = 1; // 0 means no probe
+		ping = PendingPing{PendingPing::State::WaitingForInjection,
+						   message.seq,
+						   m_nextProbe++,
+						   message.t1,
+						   time_sync::now()};
+		m_stampNext = ping.probe;
+		break;
+	}
+	case time_sync::Message::Kind::Done:
+		for (PendingPing &ping : m_pings)
+		{
+			if (ping.state != PendingPing::State::WaitingForDone || ping.seq != message.seq)
+				continue;
+			m_clock.addExchange(ping.t1, ping.t2, ping.t3, message.t4);
+			// Latest offset estimate, the touch happened at t1 on the client's clock
+			const int64_t latency = ping.ti - m_clock.toServerTime(ping.t1);
+			if (latency >= 0)
+				m_endToEndLatency.record(static_cast<uint64_t>(latency) * 1000);
+			ping.state = PendingPing::State::Free;
+			break;
+		}
+		break;
+	case time_sync::Message::Kind::Hello:
+	{
+		time_sync::Message welcome;
+		welcome.kind = time_sync::Message::Kind::Welcome;
+		welcome.version = time_sync::PROTOCOL_VERSION;
+		// Every version so far has the same meaning for the capability bits
+		welcome.capabilities =
+			message.capabilities & (time_sync::CAPABILITY_COMPACT_FRAMES | time_sync::CAPABILITY_HEARTBEAT);
+		m_compactFrames = (welcome.capabilities & time_sync::CAPABILITY_COMPACT_FRAMES) != 0;
+		m_heartbeat = (welcome.capabilities & time_sync::CAPABILITY_HEARTBEAT) != 0;
+		m_stats.compactFrames = m_compactFrames;
+		m_stats.heartbeat = m_heartbeat;
+		qInfo() << "Session" << m_id << "negotiated"
+				<< (m_compactFrames ? "compact frames" : "Colfer readings");
+		if (m_reply)
+			m_reply(time_sync::encode(welcome));
+		break;
+	}
+	case time_sync::Message::Kind::Pong:
+	case time_sync::Message::Kind::Welcome:
+		m_stats.parseErrors++; // Only the server sends those
+		break;
+	}
+}
+
+void ClientSession::flushEchoes()
+{
+	uint32_t probe = 0;
+	int64_t injectedAt = 0;
+	while (m_injector.pollInjectedProbe(probe, injectedAt))
+	{
+		for (PendingPing &ping : m_pings)
+		{
+			if (ping.state != PendingPing::State::WaitingForInjection || ping.probe != probe)
+				continue;
+			ping.ti = injectedAt;
+			ping.t3 = time_sync::now();
+			ping.state = PendingPing::State::WaitingForDone;
+			if (m_reply)
+			{
+				time_sync::Message pong;
+				pong.kind = time_sync::Message::Kind::Pong;
+				pong.seq = ping.seq;
+				pong.t1 = ping.t1;
+				pong.t2 = ping.t2;
+				pong.ti = ping.ti;
+				pong.t3 = ping.t3;
+				m_reply(time_sync::encode(pong));
+			}
+			break;
+		}
+	}
+}
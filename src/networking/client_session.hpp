@@ -0,0 +1,216 @@
+#pragma once
+
+#include "capture.hpp"
+#include "compact_frame.hpp"
+#include "histogram.hpp"
+#include "injection_worker.hpp"
+#include "receive_buffer.hpp"
+#include "session_stats.hpp"
+#include "time_sync.hpp"
+#include "udp_frame.hpp"
+
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QIODevice>
+#include <QString>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <memory>
+
+/**
+ * @brief Everything that belongs to one connected client.
+ *
+ * @details
+ * Each session has its own executor (and with it, its own virtual devices),
+ * its own injection thread, its own parse buffer and its own stats.
+ * A slow or misbehaving client therefore cannot delay the inputs of another one.
+ *
+ * Receiving runs on the network thread, which is the single producer of the injection queue.
+ *
+ * Clients may interleave time_sync control frames with their readings to measure the latency
+ * from a touch to its injection, or to negotiate compact frames and heartbeats. The answers go out
+ * through the reply channel.
+ *
+ * A client that drops off the network may stay connected for many seconds before the socket notices.
+ * checkStall() releases its inputs once it has been silent for the stall timeout while holding some:
+ * HEARTBEAT_MISSES heartbeat intervals if it negotiated heartbeats, the configured timeout otherwise.
+ */
+class ClientSession
+{
+  public:
+	/**
+	 * Size of the stream receive buffer. Far larger than any reading, small enough to cap a flood.
+	 */
+	static constexpr std::size_t RECEIVE_BUFFER_SIZE = 4096;
+
+	/**
+	 * Readings decoded by one parse_gamepad_states() call, more are decoded in the next one.
+	 */
+	static constexpr std::size_t PARSE_BATCH_SIZE = 64;
+
+	/**
+	 * @param injectionRate Fixed injection rate in Hz, 0 injects readings as they arrive.
+	 * @param lowLatency Scheduling of the injection thread.
+	 */
+	ClientSession(quint64 id,
+				  const QString &description,
+				  std::unique_ptr<ExecutorInterface> executor,
+				  int injectionRate = 0,
+				  const low_latency::Options &lowLatency = {});
+	~ClientSession();
+
+	// Delete copy and move operations, the injection thread is bound to this session
+	ClientSession(const ClientSession &) = delete;
+	ClientSession &operator=(const ClientSession &) = delete;
+	ClientSession(ClientSession &&) = delete;
+	ClientSession &operator=(ClientSession &&) = delete;
+
+	quint64 id() const
+	{
+		return m_id;
+	}
+
+	const QString &description() const
+	{
+		return m_description;
+	}
+
+	/**
+	 * @brief Reads everything available from a stream socket and injects every complete reading.
+	 * @return false if the client sent something that can never parse, the connection should be dropped.
+	 */
+	bool readStream(QIODevice *device);
+
+	/**
+	 * @brief Same as readStream(), for bytes some other receive path already read from the socket.
+	 */
+	bool receiveStream(const char *data, std::size_t len);
+
+	/**
+	 * @brief Handles one datagram of the UDP transport.
+	 */
+	void receiveDatagram(const uint8_t *data, std::size_t len);
+
+	/**
+	 * @brief Handles compact frames of the shared-memory transport, FRAME_SIZE bytes each.
+	 * That transport carries nothing else, its frames need no handshake.
+	 */
+	void receiveFrames(const uint8_t *frames, std::size_t count);
+
+	/**
+	 * @brief Sets how to send bytes back to the client.
+	 */
+	void setReplyChannel(std::function<void(const QByteArray &)> reply)
+	{
+		m_reply = std::move(reply);
+	}
+
+	/**
+	 * @brief Records every received byte to @p writer, nullptr stops recording.
+	 */
+	void setCapture(CaptureWriter *writer)
+	{
+		m_capture = writer;
+	}
+
+	/**
+	 * @brief Silence after which a client holding inputs is declared stalled, 0 to never.
+	 * Clients that negotiated heartbeats use a shorter timeout of their own.
+	 */
+	void setStallTimeout(qint64 milliseconds)
+	{
+		m_stallTimeout = milliseconds;
+	}
+
+	/**
+	 * @brief Releases every input of the client, in one injection, if it stalled.
+	 * Called every few milliseconds by the network thread, also hands over readings held back
+	 * while the injection queue was full.
+	 */
+	void checkStall();
+
+	/**
+	 * @brief Answers the pings whose reading has been injected since the last call.
+	 * Called on every receive, and periodically for clients that went quiet.
+	 */
+	void flushEchoes();
+
+	/**
+	 * @brief Milliseconds since the last byte was received from the client.
+	 */
+	qint64 idleTime() const;
+
+	SessionStats snapshot() const;
+
+	// Peer of a UDP session, datagrams are matched against it
+	QHostAddress udpPeer;
+	quint16 udpPeerPort = 0;
+
+  private:
+	using Clock = std::chrono::steady_clock;
+
+	void deliverReading(const vgp_data_exchange_gamepad_reading &reading, Clock::time_point arrival);
+	void markReceived();
+	void parseBuffered(Clock::time_point arrival);
+	/**
+	 * @brief Decodes and delivers a compact frame of FRAME_SIZE bytes.
+	 * @return false if compact frames were not negotiated or the frame is malformed.
+	 */
+	bool receiveCompact(const uint8_t *data, Clock::time_point arrival);
+	bool deliverCompact(const uint8_t *data, Clock::time_point arrival);
+	void handleControl(const time_sync::Message &message);
+
+	/**
+	 * A ping on its way through the server, see time_sync.hpp for the timestamps.
+	 */
+	struct PendingPing
+	{
+		enum class State
+		{
+			Free,
+			WaitingForInjection,
+			WaitingForDone
+		};
+		State state = State::Free;
+		uint32_t seq = 0;
+		uint32_t probe = 0;
+		int64_t t1 = 0;
+		int64_t t2 = 0;
+		int64_t ti = 0;
+		int64_t t3 = 0;
+	};
+
+	quint64 m_id;
+	QString m_description;
+	InjectionWorker m_injector;
+	UdpSequencer m_sequencer;
+
+	ReceiveBuffer<RECEIVE_BUFFER_SIZE> m_dataBuffer; // Buffer to store incoming data
+	std::array<vgp_data_exchange_gamepad_reading, PARSE_BATCH_SIZE> m_batch; // Output of the parser
+	Clock::time_point m_lastArrival;
+	bool m_hasArrival = false;
+	Histogram m_interArrivalTime; // Nanoseconds between two readings
+	Histogram m_parseTime;		  // Nanoseconds spent decoding one reading, averaged per batch
+	QElapsedTimer m_lastReceive;
+	SessionStats m_stats;
+
+	CaptureWriter *m_capture = nullptr; // Owned by the NetworkWorker
+	std::function<void(const QByteArray &)> m_reply;
+	std::array<PendingPing, 8> m_pings; // Oldest ones are recycled if the client never answers
+	std::size_t m_nextPing = 0;
+	uint32_t m_nextProbe = 1;
+	uint32_t m_stampNext = 0; // Probe for the next reading, 0 for none
+	ClockSync m_clock;
+	Histogram m_endToEndLatency; // Nanoseconds from the touch to its injection
+	bool m_compactFrames = false; // Accepted in the handshake
+
+	// Watchdog, see checkStall()
+	qint64 m_stallTimeout = 0; // Milliseconds, 0 for none
+	bool m_heartbeat = false;  // Accepted in the handshake
+	uint32_t m_heldButtons = 0;
+	bool m_analogActive = false; // A stick or trigger away from its rest position
+	bool m_stalled = false;
+	Clock::time_point m_stallStart;
+	Histogram m_stallDuration; // Nanoseconds from the release to the next byte
+};
@@ -0,0 +1,88 @@
+#include "compact_frame.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+constexpr float AXIS_SCALE = 32767.0f;
+constexpr float TRIGGER_SCALE = 65535.0f;
+
+uint16_t read_be16(const uint8_t *p)
+{
+	return static_cast<uint16_t>(p[0] << 8 | p[1]);
+}
+
+void write_be16(uint8_t *p, uint16_t v)
+{
+	p[0] = static_cast<uint8_t>(v >> 8);
+	p[1] = static_cast<uint8_t>(v);
+}
+
+float axis(const uint8_t *p)
+{
+	// -32768 has no counterpart, it reads as -1.0 like -32767
+	return std::max(static_cast<float>(static_cast<int16_t>(read_be16(p))) / AXIS_SCALE, -1.0f);
+}
+
+float trigger(const uint8_t *p)
+{
+	return static_cast<float>(read_be16(p)) / TRIGGER_SCALE;
+}
+
+uint16_t quantizeAxis(float value)
+{
+	if (std::isnan(value)) [[unlikely]]
+		return 0;
+	const long quantized = std::lround(std::clamp(value, -1.0f, 1.0f) * AXIS_SCALE);
+	return static_cast<uint16_t>(static_cast<int16_t>(quantized));
+}
+
+uint16_t quantizeTrigger(float value)
+{
+	if (std::isnan(value)) [[unlikely]]
+		return 0;
+	return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * TRIGGER_SCALE));
+}
+} // namespace
+
+bool compact_frame::decode(const uint8_t *data, udp_frame::Frame &frame)
+{
+	if (data[0] != MARKER || data[1] != 0)
+		return false;
+
+	frame.sequence = read_be16(data + 2);
+	frame.button_state = read_be16(data + 4);
+	frame.reading.buttons_up = 0;
+	frame.reading.buttons_down = 0;
+	frame.reading.left_trigger = trigger(data + 6);
+	frame.reading.right_trigger = trigger(data + 8);
+	frame.reading.left_thumbstick_x = axis(data + 10);
+	frame.reading.left_thumbstick_y = axis(data + 12);
+	frame.reading.right_thumbstick_x = axis(data + 14);
+	frame.reading.right_thumbstick_y = axis(data + 16);
+	return true;
+}
+
+std::size_t compact_frame::encode(const udp_frame::Frame &frame, uint8_t *buf)
+{
+	buf[0] = MARKER;
+	buf[1] = 0;
+	write_be16(buf + 2, static_cast<uint16_t>(frame.sequence));
+	write_be16(buf + 4, static_cast<uint16_t>(frame.button_state));
+	write_be16(buf + 6, quantizeTrigger(frame.reading.left_trigger));
+	write_be16(buf + 8, quantizeTrigger(frame.reading.right_trigger));
+	write_be16(buf + 10, quantizeAxis(frame.reading.left_thumbstick_x));
+	write_be16(buf + 12, quantizeAxis(frame.reading.left_thumbstick_y));
+	write_be16(buf + 14, quantizeAxis(frame.reading.right_thumbstick_x));
+	write_be16(buf + 16, quantizeAxis(frame.reading.right_thumbstick_y));
+	return FRAME_SIZE;
+}
+
+uint32_t compact_frame::extendSequence(uint16_t sequence, uint32_t previous)
+{
+	// Signed distance on the 16-bit circle, applied to the full number
+	const auto distance = static_cast<uint16_t>(sequence - static_cast<uint16_t>(previous));
+	const auto delta = static_cast<int16_t>(distance);
+	return previous + static_cast<uint32_t>(static_cast<int32_t>(delta));
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "udp_frame.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file compact_frame.hpp
+ * @brief Fixed-size frame format, used instead of Colfer readings once negotiated.
+ *
+ * @details
+ * A client that sent a `hello` offering time_sync::CAPABILITY_COMPACT_FRAMES and got a `welcome`
+ * accepting it may send compact frames instead of Colfer readings, over TCP or as UDP datagrams.
+ * Colfer readings are still accepted, so a client switches whenever it wants to.
+ *
+ * | Offset | Size | Field                                                      |
+ * |--------|------|------------------------------------------------------------|
+ * | 0      | 1    | MARKER                                                     |
+ * | 1      | 1    | Flags, reserved, must be 0                                 |
+ * | 2      | 2    | Sequence number, wraps around                              |
+ * | 4      | 2    | Absolute button state (GamepadButtons bits held)           |
+ * | 6      | 2    | Left trigger, unsigned, 0 to 65535 for 0.0 to 1.0          |
+ * | 8      | 2    | Right trigger                                              |
+ * | 10     | 2    | Left thumbstick x, signed, -32767 to 32767 for -1.0 to 1.0 |
+ * | 12     | 2    | Left thumbstick y                                          |
+ * | 14     | 2    | Right thumbstick x                                         |
+ * | 16     | 2    | Right thumbstick y                                         |
+ *
+ * Every field is big-endian. A frame is 18 bytes whatever the state, against up to 45 bytes for a
+ * Colfer reading (57 in a UDP datagram), and decoding it is a handful of loads without a branch
+ * per field. MARKER is never the first byte of a Colfer reading or of a control frame,
+ * so the three can be mixed in a stream.
+ *
+ * Like UDP datagrams, frames carry the absolute button state: the edges are derived by an
+ * UdpSequencer, which also drops stale frames on the UDP transport.
+ */
+namespace compact_frame
+{
+constexpr uint8_t MARKER = 0xC6;
+constexpr std::size_t FRAME_SIZE = 18;
+
+/**
+ * @brief Decodes the frame at the start of @p data, which holds at least FRAME_SIZE bytes.
+ *
+ * @param frame Gets the 16-bit sequence number, see extendSequence().
+ * @return false if the frame is malformed.
+ */
+bool decode(const uint8_t *data, udp_frame::Frame &frame);
+
+/**
+ * @brief Encodes a frame (used by clients and test tools).
+ *
+ * Only the low 16 bits of the sequence number are sent, analog values are clamped to their range.
+ *
+ * @param buf At least FRAME_SIZE bytes
+ * @return FRAME_SIZE
+ */
+std::size_t encode(const udp_frame::Frame &frame, uint8_t *buf);
+
+/**
+ * @brief The 32-bit sequence number closest to @p previous that ends with @p sequence.
+ */
+uint32_t extendSequence(uint16_t sequence, uint32_t previous);
+} // namespace compact_frame
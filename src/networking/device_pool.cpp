@@ -0,0 +1,115 @@
+#include "device_pool.hpp"
+
+#include <QDebug>
+#include <exception>
+#include <utility>
+
+/**
+ * @brief A leased executor, returned to its pool when destroyed.
+ */
+class DevicePool::Lease : public ExecutorInterface
+{
+  public:
+	Lease(DevicePool &pool, ExecutorType type, std::unique_ptr<ExecutorInterface> executor)
+		: m_pool(pool), m_type(type), m_executor(std::move(executor))
+	{
+	}
+
+	~Lease() override
+	{
+		m_pool.giveBack(m_type, std::move(m_executor));
+	}
+
+	// Delete copy and move operations, the executor is returned exactly once
+	Lease(const Lease &) = delete;
+	Lease &operator=(const Lease &) = delete;
+	Lease(Lease &&) = delete;
+	Lease &operator=(Lease &&) = delete;
+
+	bool inject_gamepad_state(vgp_data_exchange_gamepad_reading const &reading) override
+	{
+		return m_executor->inject_gamepad_state(reading);
+	}
+
+  private:
+	DevicePool &m_pool;
+	ExecutorType m_type;
+	std::unique_ptr<ExecutorInterface> m_executor;
+};
+
+void DevicePool::reserve(ExecutorType type, std::size_t capacity)
+{
+	std::vector<std::unique_ptr<ExecutorInterface>> dropped;
+	std::size_t missing = 0;
+	{
+		std::lock_guard lock(m_mutex);
+		if (type != m_type)
+		{
+			dropped.swap(m_idle);
+			m_type = type;
+		}
+		m_capacity = capacity;
+		while (m_idle.size() > m_capacity)
+		{
+			dropped.push_back(std::move(m_idle.back()));
+			m_idle.pop_back();
+		}
+		missing = m_capacity - m_idle.size();
+	}
+	dropped.clear(); // Outside the lock, removing a device takes a while too
+
+	for (; missing > 0; --missing)
+	{
+		auto executor = createExecutor(type);
+		std::lock_guard lock(m_mutex);
+		if (m_type != type || m_idle.size() >= m_capacity)
+			return; // Reserved again meanwhile
+		m_idle.push_back(std::move(executor));
+	}
+}
+
+std::unique_ptr<ExecutorInterface> DevicePool::lease(ExecutorType type)
+{
+	std::unique_ptr<ExecutorInterface> executor;
+	{
+		std::lock_guard lock(m_mutex);
+		if (type == m_type && !m_idle.empty())
+		{
+			executor = std::move(m_idle.back());
+			m_idle.pop_back();
+		}
+	}
+	if (executor)
+		qInfo() << "Reusing pooled input devices";
+	else
+		executor = createExecutor(type);
+	return std::make_unique<Lease>(*this, type, std::move(executor));
+}
+
+void DevicePool::close()
+{
+	std::vector<std::unique_ptr<ExecutorInterface>> dropped;
+	std::lock_guard lock(m_mutex);
+	m_capacity = 0;
+	dropped.swap(m_idle);
+}
+
+void DevicePool::giveBack(ExecutorType type, std::unique_ptr<ExecutorInterface> executor)
+{
+	try
+	{
+		// Whatever the last session held must not be pressed for the next one
+		if (!executor->inject_gamepad_state(release_reading()))
+			return;
+	}
+	catch (const std::exception &e)
+	{
+		qWarning() << "Dropping input devices that could not be released:" << e.what();
+		return;
+	}
+
+	std::lock_guard lock(m_mutex);
+	if (type == m_type && m_idle.size() < m_capacity)
+		m_idle.push_back(std::move(executor));
+	// Otherwise destroyed on return, after the lock is released
+}
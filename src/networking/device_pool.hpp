@@ -0,0 +1,80 @@
+#pragma once
+
+#include "executor.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Process-wide pool of executors, and with them of virtual input devices, reused across sessions.
+ *
+ * @details
+ * Creating an executor creates its devices: a virtual controller for the gamepad executor, a keyboard
+ * and a mouse for the keyboard-mouse one. That takes hundreds of milliseconds on Linux, until udev has
+ * settled, and games see a controller disappear and reappear on every reconnect.
+ *
+ * Sessions lease an executor instead. When the lease ends, the executor is released to a neutral state
+ * (see release_reading()) and kept idle for the next session, up to the capacity of the pool.
+ * Only executors of the reserved type are kept, switching the type drops the idle ones.
+ *
+ * Thread safe, leases may end on any thread.
+ */
+class DevicePool
+{
+  public:
+	/**
+	 * Idle executors kept by default, enough for one client reconnecting.
+	 */
+	static constexpr std::size_t DEFAULT_CAPACITY = 1;
+
+	static DevicePool &instance()
+	{
+		static DevicePool _instance;
+		return _instance;
+	}
+
+	// Delete copy and move operations of the singleton
+	DevicePool(const DevicePool &) = delete;
+	DevicePool &operator=(const DevicePool &) = delete;
+	DevicePool(DevicePool &&) = delete;
+	DevicePool &operator=(DevicePool &&) = delete;
+
+	/**
+	 * @brief Keeps up to @p capacity idle executors of @p type, and none of any other type.
+	 *
+	 * The missing ones are created right away, so the first client connects as fast as the next ones.
+	 * A capacity of 0 creates and destroys the devices with every session.
+	 * @throws std::exception if the devices cannot be created, the pool keeps what it has then.
+	 */
+	void reserve(ExecutorType type, std::size_t capacity);
+
+	/**
+	 * @brief An idle executor of @p type, or a new one if there is none.
+	 *
+	 * Destroying the returned executor returns it to the pool.
+	 * @throws std::exception like createExecutor().
+	 */
+	std::unique_ptr<ExecutorInterface> lease(ExecutorType type);
+
+	/**
+	 * @brief Destroys the idle executors, and every leased one when its lease ends.
+	 *
+	 * Call before leaving main(), so the devices are removed while the platform APIs still work.
+	 */
+	void close();
+
+  private:
+	class Lease;
+
+	DevicePool() = default;
+	~DevicePool() = default;
+
+	void giveBack(ExecutorType type, std::unique_ptr<ExecutorInterface> executor);
+
+	std::mutex m_mutex;
+	ExecutorType m_type{};
+	std::size_t m_capacity = 0; // 0 until reserve(), leases are not kept before
+	std::vector<std::unique_ptr<ExecutorInterface>> m_idle;
+};
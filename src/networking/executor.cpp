@@ -5,20 +5,19 @@
 #include "../simulation/gamepadSim.hpp"
 #include "../simulation/keyboardSim.hpp"
 #include "../simulation/mouseSim.hpp"
+#include "compact_frame.hpp"
+#include "time_sync.hpp"
 
-#include <QApplication>
 #include <QDebug>
 #include <algorithm>
+#include <bit>
 #include <cmath>
 #include <errno.h>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
-/**
- * Converts a circular position (x,y with radius=1) to square coordinates.
- * This allows diagonal movement to reach (1,1) instead of (0.71,0.71).
- */
 std::pair<float, float> circleToSquare(float x, float y)
 {
 	// Fast path for common cases
@@ -93,9 +92,13 @@ std::string getButtonNames(uint32_t buttons)
 	return oss.str();
 }
 
-ParseResult parse_gamepad_state(const char *data, size_t len)
+namespace
+{
+/**
+ * @brief Decodes one reading with the generated Colfer code.
+ */
+void unmarshal_reading(const char *data, size_t len, ParseResult &result)
 {
-	ParseResult result;
 	result.reading.buttons_up = 0;
 	result.reading.buttons_down = 0;
 	result.reading.left_trigger = 0;
@@ -133,28 +136,159 @@ ParseResult parse_gamepad_state(const char *data, size_t len)
 		{
 			qWarning() << "Unknown error occurred during deserialization";
 		}
-		return result;
+		return;
 	}
 
 	result.bytes_consumed = decoded_octects;
 	result.success = true;
+}
+
+BatchParseResult::Stop batch_stop(ParseResult::FailureReason reason)
+{
+	switch (reason)
+	{
+	case ParseResult::FailureReason::IncompleteData:
+		return BatchParseResult::Stop::IncompleteData;
+	case ParseResult::FailureReason::DataTooLarge:
+		return BatchParseResult::Stop::DataTooLarge;
+	default:
+		return BatchParseResult::Stop::SchemaMismatch;
+	}
+}
 
+/**
+ * @brief Logs a decoded reading in debug builds.
+ */
+void log_reading([[maybe_unused]] const vgp_data_exchange_gamepad_reading &reading)
+{
 #ifdef QT_DEBUG
-	// Log the gamepad state
 	qDebug() << "Gamepad state:"
-			 << "\nButtons up: " << getButtonNames(result.reading.buttons_up).c_str()
-			 << "\nButtons down: " << getButtonNames(result.reading.buttons_down).c_str()
-			 << "\nLeft trigger: " << result.reading.left_trigger
-			 << "\nRight trigger: " << result.reading.right_trigger
-			 << "\nLeft thumbstick x: " << result.reading.left_thumbstick_x
-			 << "\nLeft thumbstick y: " << result.reading.left_thumbstick_y
-			 << "\nRight thumbstick x: " << result.reading.right_thumbstick_x
-			 << "\nRight thumbstick y: " << result.reading.right_thumbstick_y;
+			 << "\nButtons up: " << getButtonNames(reading.buttons_up).c_str()
+			 << "\nButtons down: " << getButtonNames(reading.buttons_down).c_str()
+			 << "\nLeft trigger: " << reading.left_trigger
+			 << "\nRight trigger: " << reading.right_trigger
+			 << "\nLeft thumbstick x: " << reading.left_thumbstick_x
+			 << "\nLeft thumbstick y: " << reading.left_thumbstick_y
+			 << "\nRight thumbstick x: " << reading.right_thumbstick_x
+			 << "\nRight thumbstick y: " << reading.right_thumbstick_y;
 #endif
+}
+
+/**
+ * @brief Level below which a pressed input is released, never less than half its threshold.
+ */
+double releaseLevel(double threshold, double hysteresis)
+{
+	return threshold - std::min(hysteresis, threshold / 2);
+}
+
+/**
+ * @brief @p reading with its sticks and triggers conditioned by @p axes, see AxisTables.
+ */
+vgp_data_exchange_gamepad_reading conditioned(const vgp_data_exchange_gamepad_reading &reading,
+											  const AxisTables &axes)
+{
+	if (!axes.enabled) [[likely]]
+		return reading;
+
+	float values[AxisTables::AXIS_COUNT];
+	values[AxisTables::LeftX] = reading.left_thumbstick_x;
+	values[AxisTables::LeftY] = reading.left_thumbstick_y;
+	values[AxisTables::RightX] = reading.right_thumbstick_x;
+	values[AxisTables::RightY] = reading.right_thumbstick_y;
+	values[AxisTables::LeftTrigger] = reading.left_trigger;
+	values[AxisTables::RightTrigger] = reading.right_trigger;
+	axes.apply(values);
+
+	vgp_data_exchange_gamepad_reading result = reading;
+	result.left_thumbstick_x = values[AxisTables::LeftX];
+	result.left_thumbstick_y = values[AxisTables::LeftY];
+	result.right_thumbstick_x = values[AxisTables::RightX];
+	result.right_thumbstick_y = values[AxisTables::RightY];
+	result.left_trigger = values[AxisTables::LeftTrigger];
+	result.right_trigger = values[AxisTables::RightTrigger];
+	return result;
+}
+} // namespace
+
+ParseResult parse_gamepad_state(const char *data, size_t len)
+{
+	ParseResult result;
+	unmarshal_reading(data, len, result);
+	if (!result.success) [[unlikely]]
+		return result;
+
+	log_reading(result.reading);
 
 	return result;
 }
 
+BatchParseResult parse_gamepad_states(std::span<const std::byte> data,
+									  std::span<vgp_data_exchange_gamepad_reading> readings)
+{
+	const char *const begin = reinterpret_cast<const char *>(data.data());
+	BatchParseResult batch{0, 0, BatchParseResult::Stop::EndOfData};
+
+	while (batch.bytes_consumed < data.size())
+	{
+		const char *frame = begin + batch.bytes_consumed;
+		const auto first = static_cast<uint8_t>(*frame);
+		if (first == time_sync::CONTROL_BYTE || first == compact_frame::MARKER)
+		{
+			batch.stop = BatchParseResult::Stop::OtherFrame;
+			break;
+		}
+		if (batch.count == readings.size())
+		{
+			batch.stop = BatchParseResult::Stop::OutputFull;
+			break;
+		}
+
+		ParseResult parsed;
+		unmarshal_reading(frame, data.size() - batch.bytes_consumed, parsed);
+		if (!parsed.success) [[unlikely]]
+		{
+			batch.stop = batch_stop(parsed.failure_reason);
+			break;
+		}
+
+		readings[batch.count] = parsed.reading;
+		log_reading(parsed.reading);
+		batch.count++;
+		batch.bytes_consumed += parsed.bytes_consumed;
+	}
+	return batch;
+}
+
+vgp_data_exchange_gamepad_reading release_reading()
+{
+	vgp_data_exchange_gamepad_reading reading{};
+	reading.buttons_up = GamepadButtons_Menu | GamepadButtons_View | GamepadButtons_A | GamepadButtons_B |
+						 GamepadButtons_X | GamepadButtons_Y | GamepadButtons_DPadUp |
+						 GamepadButtons_DPadDown | GamepadButtons_DPadLeft | GamepadButtons_DPadRight |
+						 GamepadButtons_LeftShoulder | GamepadButtons_RightShoulder |
+						 GamepadButtons_LeftThumbstick | GamepadButtons_RightThumbstick;
+	return reading;
+}
+
+bool coalesce_readings(vgp_data_exchange_gamepad_reading &into,
+					   const vgp_data_exchange_gamepad_reading &next)
+{
+	// A press and a release of the same button must reach the executor in order
+	if ((into.buttons_down & next.buttons_up) != 0 || (into.buttons_up & next.buttons_down) != 0)
+		return false;
+
+	into.buttons_down |= next.buttons_down;
+	into.buttons_up |= next.buttons_up;
+	into.left_trigger = next.left_trigger;
+	into.right_trigger = next.right_trigger;
+	into.left_thumbstick_x = next.left_thumbstick_x;
+	into.left_thumbstick_y = next.left_thumbstick_y;
+	into.right_thumbstick_x = next.right_thumbstick_x;
+	into.right_thumbstick_y = next.right_thumbstick_y;
+	return true;
+}
+
 KeyboardMouseExecutor::KeyboardMouseExecutor()
 {
 	try
@@ -169,189 +303,243 @@ KeyboardMouseExecutor::KeyboardMouseExecutor()
 	}
 }
 
-void KeyboardMouseExecutor::handleButtonDown(const ButtonInput &buttonInput)
+std::size_t KeyboardMouseExecutor::stateIndex(const KeymapPlan::Action &action)
 {
-	if (buttonInput.is_mouse_button)
+	switch (action.target)
 	{
-#ifdef WIN32
-		if (buttonInput.vk == VK_LBUTTON)
-			m_mouseInjector->leftDown();
-		else if (buttonInput.vk == VK_RBUTTON)
-			m_mouseInjector->rightDown();
-		else if (buttonInput.vk == VK_MBUTTON)
-			m_mouseInjector->middleDown();
-#elif defined(__linux__)
-		if (buttonInput.vk == BTN_LEFT)
-			m_mouseInjector->leftDown();
-		else if (buttonInput.vk == BTN_RIGHT)
-			m_mouseInjector->rightDown();
-		else if (buttonInput.vk == BTN_MIDDLE)
-			m_mouseInjector->middleDown();
-#endif
-		else [[unlikely]] // Unknown mouse button, do nothing
-			qWarning() << "Unknown mouse button pressed: " << buttonInput.vk;
+	case KeymapPlan::Target::Key:
+		return action.key < KEY_STATE_COUNT ? static_cast<std::size_t>(action.key) : KEY_STATE_COUNT + 3;
+	case KeymapPlan::Target::MouseLeft:
+		return KEY_STATE_COUNT;
+	case KeymapPlan::Target::MouseRight:
+		return KEY_STATE_COUNT + 1;
+	case KeymapPlan::Target::MouseMiddle:
+		return KEY_STATE_COUNT + 2;
+	case KeymapPlan::Target::None:
+		break;
 	}
-	else
+	return KEY_STATE_COUNT + 3;
+}
+
+bool KeyboardMouseExecutor::isDown(const KeymapPlan::Action &action) const
+{
+	const std::size_t index = stateIndex(action);
+	return index < m_down.size() && m_down.test(index);
+}
+
+void KeyboardMouseExecutor::injectDown(const KeymapPlan::Action &action)
+{
+	switch (action.target)
 	{
-		m_keyboardInjector->keyDown(buttonInput.vk);
+	case KeymapPlan::Target::None:
+		break;
+	case KeymapPlan::Target::Key:
+		m_keyboardInjector->keyDown(action.key);
+		break;
+	case KeymapPlan::Target::MouseLeft:
+		m_mouseInjector->leftDown();
+		break;
+	case KeymapPlan::Target::MouseRight:
+		m_mouseInjector->rightDown();
+		break;
+	case KeymapPlan::Target::MouseMiddle:
+		m_mouseInjector->middleDown();
+		break;
 	}
 }
 
-void KeyboardMouseExecutor::handleButtonUp(const ButtonInput &buttonInput)
+void KeyboardMouseExecutor::injectUp(const KeymapPlan::Action &action)
 {
-	if (buttonInput.is_mouse_button)
+	switch (action.target)
 	{
-#ifdef WIN32
-		if (buttonInput.vk == VK_LBUTTON)
-			m_mouseInjector->leftUp();
-		else if (buttonInput.vk == VK_RBUTTON)
-			m_mouseInjector->rightUp();
-		else if (buttonInput.vk == VK_MBUTTON)
-			m_mouseInjector->middleUp();
-#elif defined(__linux__)
-		if (buttonInput.vk == BTN_LEFT)
-			m_mouseInjector->leftUp();
-		else if (buttonInput.vk == BTN_RIGHT)
-			m_mouseInjector->rightUp();
-		else if (buttonInput.vk == BTN_MIDDLE)
-			m_mouseInjector->middleUp();
-#endif
-		else [[unlikely]] // Unknown mouse button, do nothing
-			qWarning() << "Unknown mouse button released: " << buttonInput.vk;
+	case KeymapPlan::Target::None:
+		break;
+	case KeymapPlan::Target::Key:
+		m_keyboardInjector->keyUp(action.key);
+		break;
+	case KeymapPlan::Target::MouseLeft:
+		m_mouseInjector->leftUp();
+		break;
+	case KeymapPlan::Target::MouseRight:
+		m_mouseInjector->rightUp();
+		break;
+	case KeymapPlan::Target::MouseMiddle:
+		m_mouseInjector->middleUp();
+		break;
 	}
-	else
+}
+
+void KeyboardMouseExecutor::releaseAll()
+{
+	for (std::size_t key = 0; key < KEY_STATE_COUNT; ++key)
 	{
-		m_keyboardInjector->keyUp(buttonInput.vk);
+		if (m_down.test(key))
+			m_keyboardInjector->keyUp(static_cast<InputKeyCode>(key));
 	}
+	if (m_down.test(KEY_STATE_COUNT))
+		m_mouseInjector->leftUp();
+	if (m_down.test(KEY_STATE_COUNT + 1))
+		m_mouseInjector->rightUp();
+	if (m_down.test(KEY_STATE_COUNT + 2))
+		m_mouseInjector->middleUp();
+	m_down.reset();
 }
 
-void KeyboardMouseExecutor::handleThumbstickInput(const ThumbstickInput &thumbstick,
-												  float x_value,
-												  float y_value,
-												  double threshold)
+void KeyboardMouseExecutor::handleButtonDown(const KeymapPlan::Action &action)
 {
-	// Convert circular area to square area
-	auto [squareX, squareY] = circleToSquare(x_value, y_value);
+	if (const std::size_t index = stateIndex(action); index < m_down.size())
+	{
+		if (m_down.test(index))
+			return;
+		m_down.set(index);
+	}
+	injectDown(action);
+}
 
-	if (thumbstick.is_mouse_move)
+void KeyboardMouseExecutor::handleButtonUp(const KeymapPlan::Action &action)
+{
+	if (const std::size_t index = stateIndex(action); index < m_down.size())
 	{
-		// Mouse movement code
-		auto offsetX = static_cast<int>(
-			squareX * static_cast<float>(SettingsSingleton::instance().mouseSensitivity()));
-		auto offsetY = static_cast<int>(
-			squareY * static_cast<float>(SettingsSingleton::instance().mouseSensitivity()));
-
-		// Only move if offset is above threshold
-		if (double thresholdPixels =
-				threshold * static_cast<double>(SettingsSingleton::instance().mouseSensitivity());
-			std::abs(offsetX) < thresholdPixels && std::abs(offsetY) < thresholdPixels)
+		if (!m_down.test(index))
 			return;
+		m_down.reset(index);
+	}
+	injectUp(action);
+}
 
-		// qDebug() << "Moving mouse by offset:" << offsetX << "," << offsetY;
+void KeyboardMouseExecutor::handleAxis(const KeymapPlan::Action &negative,
+									   const KeymapPlan::Action &positive,
+									   float value,
+									   double threshold,
+									   double hysteresis)
+{
+	const double release = releaseLevel(threshold, hysteresis);
+	const bool negativeOn = -value > (isDown(negative) ? release : threshold);
+	const bool positiveOn = value > (isDown(positive) ? release : threshold);
+
+	// Releasing first, a stick flicked from one side to the other never holds both
+	if (!negativeOn)
+		handleButtonUp(negative);
+	if (!positiveOn)
+		handleButtonUp(positive);
+	if (negativeOn)
+		handleButtonDown(negative);
+	if (positiveOn)
+		handleButtonDown(positive);
+}
 
-		// Break movement into steps for smooth movement
-		int maxSteps = std::max(std::abs(offsetX), std::abs(offsetY));
-		if (maxSteps > 0)
-		{
-			for (int step = 1; step <= maxSteps; ++step)
-			{
-				int stepX = (offsetX * step) / maxSteps - (offsetX * (step - 1)) / maxSteps;
-				int stepY = (offsetY * step) / maxSteps - (offsetY * (step - 1)) / maxSteps;
-				// qDebug() << "Moving mouse by step:" << stepX << "," << stepY;
-				m_mouseInjector->moveMouseByOffset(stepX, stepY);
-			}
-		}
-	}
-	else
+std::pair<double, double> KeyboardMouseExecutor::handleThumbstickInput(const KeymapPlan::Stick &thumbstick,
+																	   float x_value,
+																	   float y_value,
+																	   double threshold,
+																	   double hysteresis,
+																	   double speed,
+																	   double curve)
+{
+	if (thumbstick.mouseMove)
 	{
-		// Direction handling
-		if (x_value > threshold)
-			handleButtonDown(thumbstick.right);
-		else if (x_value < -threshold)
-			handleButtonDown(thumbstick.left);
-		else
-		{
-			handleButtonUp(thumbstick.right);
-			handleButtonUp(thumbstick.left);
-		}
+		// Convert circular area to square area
+		auto [squareX, squareY] = circleToSquare(x_value, y_value);
 
-		if (y_value > threshold)
-			handleButtonDown(thumbstick.down);
-		else if (y_value < -threshold)
-			handleButtonDown(thumbstick.up);
-		else
-		{
-			handleButtonUp(thumbstick.down);
-			handleButtonUp(thumbstick.up);
-		}
+		// Only move if an axis is above threshold
+		if (std::abs(squareX) < threshold && std::abs(squareY) < threshold)
+			return {0.0, 0.0};
+		return PointerMotion::velocity(squareX, squareY, speed, curve);
 	}
+
+	// Direction handling
+	handleAxis(thumbstick.left, thumbstick.right, x_value, threshold, hysteresis);
+	handleAxis(thumbstick.up, thumbstick.down, y_value, threshold, hysteresis);
+	return {0.0, 0.0};
 }
 
-void KeyboardMouseExecutor::handleTriggerInput(const TriggerInput &trigger, float trigger_value)
+void KeyboardMouseExecutor::handleTriggerInput(const KeymapPlan::TriggerAction &trigger,
+											   float trigger_value,
+											   double hysteresis)
 {
-	if (trigger_value >= trigger.threshold)
+	const double threshold = trigger.threshold;
+	if (trigger_value >= (isDown(trigger.action) ? releaseLevel(threshold, hysteresis) : threshold))
 	{
-		handleButtonDown(trigger.button_input);
+		handleButtonDown(trigger.action);
 	}
 	else
 	{
-		handleButtonUp(trigger.button_input);
+		handleButtonUp(trigger.action);
 	}
 }
 
 bool KeyboardMouseExecutor::inject_gamepad_state(vgp_data_exchange_gamepad_reading const &reading)
 {
-	// Handle button input using active keymap profile
-	const auto &profile = SettingsSingleton::instance().activeKeymapProfile();
-	static const std::vector<GamepadButtons> buttons = {GamepadButtons_Menu,
-														GamepadButtons_View,
-														GamepadButtons_A,
-														GamepadButtons_B,
-														GamepadButtons_X,
-														GamepadButtons_Y,
-														GamepadButtons_DPadUp,
-														GamepadButtons_DPadDown,
-														GamepadButtons_DPadLeft,
-														GamepadButtons_DPadRight,
-														GamepadButtons_LeftShoulder,
-														GamepadButtons_RightShoulder,
-														GamepadButtons_LeftThumbstick,
-														GamepadButtons_RightThumbstick};
-	for (auto button : buttons)
+	// Picks up a profile edited or reloaded meanwhile, a single atomic load otherwise
+	const uint64_t generation = m_planGeneration;
+	SettingsSingleton::instance().activeKeymapProfile().refreshPlan(m_plan, m_planGeneration);
+	// Everything this reading changes is written to each device at once, at the end
+	m_keyboardInjector->batch();
+	m_mouseInjector->batch();
+	if (m_planGeneration != generation) [[unlikely]]
+		releaseAll(); // Inputs held through the old mappings would never be released otherwise
+
+	// Only the mapped buttons with an edge, in the order of their bits
+	const auto down = static_cast<uint32_t>(reading.buttons_down);
+	const auto up = static_cast<uint32_t>(reading.buttons_up);
+	for (uint32_t edges = (down | up) & m_plan.mappedButtons; edges != 0; edges &= edges - 1)
 	{
-		InputKeyCode vk = profile.buttonMap(button);
-		if (vk == 0)
-			continue;
-		ButtonInput input{vk, is_mouse_button(vk), ""};
-		if (reading.buttons_down & button)
-			handleButtonDown(input);
-		if (reading.buttons_up & button)
-			handleButtonUp(input);
+		const auto bit = static_cast<std::size_t>(std::countr_zero(edges));
+		const uint32_t button = 1u << bit;
+		if (down & button)
+			handleButtonDown(m_plan.buttons[bit]);
+		if (up & button)
+			handleButtonUp(m_plan.buttons[bit]);
 	}
 
-	handleThumbstickInput(
-		SettingsSingleton::instance().activeKeymapProfile().thumbstickInput(Thumbstick_Left),
-		reading.left_thumbstick_x,
-		reading.left_thumbstick_y,
-		THRESHOLD);
-
-	handleThumbstickInput(
-		SettingsSingleton::instance().activeKeymapProfile().thumbstickInput(Thumbstick_Right),
-		reading.right_thumbstick_x,
-		reading.right_thumbstick_y,
-		THRESHOLD);
-
-	handleTriggerInput(SettingsSingleton::instance().activeKeymapProfile().triggerInput(Trigger::Left),
-					   reading.left_trigger);
+	const vgp_data_exchange_gamepad_reading analog = conditioned(reading, m_plan.axes);
+	// Atomics, read once per reading as the Preferences dialog may change them meanwhile
+	const auto &settings = SettingsSingleton::instance();
+	const double speed = settings.mouseSensitivity() * PointerMotion::REFERENCE_RATE;
+	const double curve = settings.pointerCurve();
+	const double hysteresis = m_plan.hysteresis;
+	const auto [leftX, leftY] = handleThumbstickInput(m_plan.sticks[Thumbstick_Left],
+													  analog.left_thumbstick_x,
+													  analog.left_thumbstick_y,
+													  THRESHOLD,
+													  hysteresis,
+													  speed,
+													  curve);
+	const auto [rightX, rightY] = handleThumbstickInput(m_plan.sticks[Thumbstick_Right],
+														analog.right_thumbstick_x,
+														analog.right_thumbstick_y,
+														THRESHOLD,
+														hysteresis,
+														speed,
+														curve);
+
+	// Two sticks moving the mouse add up, the pointer moves once per reading
+	if (const double vx = leftX + rightX, vy = leftY + rightY; vx != 0.0 || vy != 0.0)
+	{
+		const auto [dx, dy] = m_pointer.advance(vx, vy, PointerMotion::Clock::now());
+		if (dx != 0 || dy != 0)
+			m_mouseInjector->moveMouseByOffset(dx, dy);
+	}
+	else
+		m_pointer.stop();
 
-	handleTriggerInput(SettingsSingleton::instance().activeKeymapProfile().triggerInput(Trigger::Right),
-					   reading.right_trigger);
+	handleTriggerInput(m_plan.triggers[static_cast<std::size_t>(Trigger::Left)],
+					   analog.left_trigger,
+					   hysteresis);
+	handleTriggerInput(m_plan.triggers[static_cast<std::size_t>(Trigger::Right)],
+					   analog.right_trigger,
+					   hysteresis);
 
+	m_keyboardInjector->flush();
+	m_mouseInjector->flush();
 	return true;
 }
 
 bool GamepadExecutor::inject_gamepad_state(vgp_data_exchange_gamepad_reading const &reading)
 {
+	SettingsSingleton::instance().activeKeymapProfile().refreshPlan(m_plan, m_planGeneration);
+	const vgp_data_exchange_gamepad_reading analog = conditioned(reading, m_plan.axes);
+
 #ifdef _WIN32
 	using enum winrt::Windows::Gaming::Input::GamepadButtons;
 	// Create a new state to update thumbsticks and triggers
@@ -359,14 +547,14 @@ bool GamepadExecutor::inject_gamepad_state(vgp_data_exchange_gamepad_reading con
 	newState.Buttons(None);
 
 	// Set thumbstick values, invert Y-axis
-	newState.LeftThumbstickX(reading.left_thumbstick_x);
-	newState.LeftThumbstickY(-reading.left_thumbstick_y);
-	newState.RightThumbstickX(reading.right_thumbstick_x);
-	newState.RightThumbstickY(-reading.right_thumbstick_y);
+	newState.LeftThumbstickX(analog.left_thumbstick_x);
+	newState.LeftThumbstickY(-analog.left_thumbstick_y);
+	newState.RightThumbstickX(analog.right_thumbstick_x);
+	newState.RightThumbstickY(-analog.right_thumbstick_y);
 
 	// Set trigger values
-	newState.LeftTrigger(reading.left_trigger);
-	newState.RightTrigger(reading.right_trigger);
+	newState.LeftTrigger(analog.left_trigger);
+	newState.RightTrigger(analog.right_trigger);
 
 	// Update the gamepad state
 	m_injector.update(newState);
@@ -437,11 +625,11 @@ bool GamepadExecutor::inject_gamepad_state(vgp_data_exchange_gamepad_reading con
 	// Linux implementation using libevdev
 
 	// Set thumbstick and trigger values
-	m_injector.setThumbsticks(reading.left_thumbstick_x,
-							  -reading.left_thumbstick_y,
-							  reading.right_thumbstick_x,
-							  -reading.right_thumbstick_y);
-	m_injector.setTriggers(reading.left_trigger, reading.right_trigger);
+	m_injector.setThumbsticks(analog.left_thumbstick_x,
+							  -analog.left_thumbstick_y,
+							  analog.right_thumbstick_x,
+							  -analog.right_thumbstick_y);
+	m_injector.setTriggers(analog.left_trigger, analog.right_trigger);
 
 	// Handle button presses (mapping from our buttons to Linux input codes)
 	if (reading.buttons_down & GamepadButtons_Menu)
@@ -509,3 +697,25 @@ bool GamepadExecutor::inject_gamepad_state(vgp_data_exchange_gamepad_reading con
 
 	return true;
 }
+
+std::unique_ptr<ExecutorInterface> createExecutor(ExecutorType type)
+{
+	switch (type)
+	{
+	case ExecutorType::GamepadExecutor:
+	{
+		auto executor = std::make_unique<GamepadExecutor>();
+		qInfo() << "GamepadExecutor initialized successfully";
+		return executor;
+	}
+	case ExecutorType::KeyboardMouseExecutor:
+	{
+		auto executor = std::make_unique<KeyboardMouseExecutor>();
+		qInfo() << "KeyboardMouseExecutor initialized successfully";
+		return executor;
+	}
+	default:
+		qCritical() << "Unknown executor type";
+		throw std::invalid_argument("Unknown executor type");
+	}
+}
@@ -2,11 +2,17 @@
 
 #include "../../VGP_Data_Exchange/C/Colfer.h"
 #include "../settings/input_types.hpp"
+#include "../settings/keymap_plan.hpp"
 #include "../simulation/gamepadSim.hpp"
 #include "../simulation/keyboardSim.hpp"
 #include "../simulation/mouseSim.hpp"
+#include "pointer_motion.hpp"
 
+#include <bitset>
+#include <cstddef>
 #include <memory>
+#include <span>
+#include <utility>
 
 struct ParseResult
 {
@@ -25,6 +31,59 @@ struct ParseResult
 
 ParseResult parse_gamepad_state(const char *data, size_t len);
 
+struct BatchParseResult
+{
+	enum class Stop
+	{
+		EndOfData,		// Every byte was consumed
+		IncompleteData, // The frame at bytes_consumed is not complete yet
+		OtherFrame,		// A time_sync message or a compact frame starts at bytes_consumed
+		OutputFull,		// More readings follow than the output can hold
+		SchemaMismatch,
+		DataTooLarge
+	};
+	size_t count;		   // Readings written to the output
+	size_t bytes_consumed; // Length of those readings, where the next frame begins
+	Stop stop;
+};
+
+/**
+ * @brief Decodes every complete reading at the start of @p data into @p readings.
+ *
+ * @details
+ * Parses like repeated calls to parse_gamepad_state(), without the bookkeeping in between, and stops at
+ * the first frame that is not a complete reading. The readings before it are always returned, so after
+ * an error the caller still delivers them before dropping the rest.
+ */
+BatchParseResult parse_gamepad_states(std::span<const std::byte> data,
+									  std::span<vgp_data_exchange_gamepad_reading> readings);
+
+/**
+ * Converts a circular position (x,y with radius=1) to square coordinates.
+ * This allows diagonal movement to reach (1,1) instead of (0.71,0.71).
+ */
+std::pair<float, float> circleToSquare(float x, float y);
+
+/**
+ * @brief Merges @p next into @p into, as if both had been injected one after the other.
+ *
+ * Analog values are taken from @p next, button edges are OR-ed.
+ * Merging is refused if it would reorder edges of a button, e.g. a release followed by a press.
+ * @return false if the readings cannot be merged, @p into is then unchanged.
+ */
+bool coalesce_readings(vgp_data_exchange_gamepad_reading &into,
+					   const vgp_data_exchange_gamepad_reading &next);
+
+/**
+ * @brief A reading that releases every button and centres the sticks and triggers.
+ *
+ * Injected once for a client that went silent, so nothing it held stays pressed.
+ * Releasing a button or key that is not pressed has no effect.
+ */
+vgp_data_exchange_gamepad_reading release_reading();
+
+enum class ExecutorType;
+
 /**
  * An executor Interface for handling gamepad state injection
  */
@@ -36,6 +95,11 @@ class ExecutorInterface
 	virtual bool inject_gamepad_state(vgp_data_exchange_gamepad_reading const &reading) = 0;
 };
 
+/**
+ * @brief Executes gamepad input on a virtual gamepad.
+ *
+ * The sticks and triggers are conditioned by the responses of the active keymap profile first.
+ */
 class GamepadExecutor : public ExecutorInterface
 {
   public:
@@ -52,6 +116,8 @@ class GamepadExecutor : public ExecutorInterface
 
   private:
 	GamepadInjector m_injector;
+	KeymapPlan m_plan;			   // Only its axis tables are used
+	uint64_t m_planGeneration = 0; // See KeymapProfile::refreshPlan()
 };
 
 /**
@@ -61,6 +127,15 @@ class GamepadExecutor : public ExecutorInterface
  * This class takes gamepad input and converts it to equivalent keyboard and mouse
  * actions based on the active keymap profile. It handles button mappings,
  * thumbstick-to-mouse movement, and thumbstick-to-key mappings.
+ *
+ * It works from its own copy of the profile compiled into a KeymapPlan, refreshed when the profile
+ * changes, so processing a reading allocates nothing and looks nothing up in a map.
+ *
+ * It remembers which keys and mouse buttons it holds down and only injects actual changes, a centred
+ * stick or released trigger costs nothing. Stick directions and triggers are digitised with the
+ * hysteresis of the profile, after the responses of the profile conditioned them.
+ *
+ * Sticks moving the mouse set the velocity of the pointer, see PointerMotion.
  */
 class KeyboardMouseExecutor : public ExecutorInterface
 {
@@ -91,11 +166,48 @@ class KeyboardMouseExecutor : public ExecutorInterface
 	std::unique_ptr<KeyboardInjector> m_keyboardInjector;
 	std::unique_ptr<MouseInjector> m_mouseInjector;
 
-	void handleButtonDown(const ButtonInput &buttonInput);
-	void handleButtonUp(const ButtonInput &buttonInput);
-	void handleThumbstickInput(const ThumbstickInput &thumbstick,
-							   float x_value,
-							   float y_value,
-							   double threshold);
-	void handleTriggerInput(const TriggerInput &trigger, float trigger_value);
+	/**
+	 * Key codes whose state is tracked: every virtual-key code on Windows, up to KEY_MAX on Linux.
+	 * Anything above is injected as is.
+	 */
+	static constexpr std::size_t KEY_STATE_COUNT = 0x300;
+
+	KeymapPlan m_plan;
+	uint64_t m_planGeneration = 0;				// See KeymapProfile::refreshPlan()
+	std::bitset<KEY_STATE_COUNT + 3> m_down;	// Keys, then the left, right and middle buttons
+	PointerMotion m_pointer;
+
+	static std::size_t stateIndex(const KeymapPlan::Action &action);
+	bool isDown(const KeymapPlan::Action &action) const;
+	void injectDown(const KeymapPlan::Action &action);
+	void injectUp(const KeymapPlan::Action &action);
+	void releaseAll();
+
+	void handleButtonDown(const KeymapPlan::Action &action);
+	void handleButtonUp(const KeymapPlan::Action &action);
+	void handleAxis(const KeymapPlan::Action &negative,
+					const KeymapPlan::Action &positive,
+					float value,
+					double threshold,
+					double hysteresis);
+	/**
+	 * @return The velocity of the pointer from a stick moving the mouse, in pixels per second.
+	 */
+	std::pair<double, double> handleThumbstickInput(const KeymapPlan::Stick &thumbstick,
+													float x_value,
+													float y_value,
+													double threshold,
+													double hysteresis,
+													double speed,
+													double curve);
+	void handleTriggerInput(const KeymapPlan::TriggerAction &trigger,
+							float trigger_value,
+							double hysteresis);
 };
+
+/**
+ * @brief Creates the executor of the given type.
+ *
+ * @throws std::exception if the platform input devices cannot be created.
+ */
+std::unique_ptr<ExecutorInterface> createExecutor(ExecutorType type);
@@ -0,0 +1,74 @@
+#include "histogram.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+std::size_t Histogram::bucketIndex(uint64_t value)
+{
+	if (value < SUB_BUCKET_COUNT)
+		return static_cast<std::size_t>(value);
+	// The top SUB_BUCKET_BITS bits of the value select the bucket within its power of two
+	const auto shift = static_cast<unsigned>(std::bit_width(value)) - SUB_BUCKET_BITS;
+	const auto top = static_cast<std::size_t>(value >> shift);
+	return SUB_BUCKET_COUNT + (shift - 1) * SUB_BUCKET_HALF + (top - SUB_BUCKET_HALF);
+}
+
+uint64_t Histogram::bucketUpperBound(std::size_t index)
+{
+	if (index < SUB_BUCKET_COUNT)
+		return index;
+	const std::size_t offset = index - SUB_BUCKET_COUNT;
+	const auto shift = static_cast<unsigned>(offset / SUB_BUCKET_HALF + 1);
+	const uint64_t top = offset % SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+	return ((top + 1) << shift) - 1;
+}
+
+void Histogram::record(uint64_t value)
+{
+	// Single writer, a load and a store are enough and cheaper than a locked increment
+	auto &bucket = m_buckets[bucketIndex(value)];
+	bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	m_sum.store(m_sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	if (value > m_max.load(std::memory_order_relaxed))
+		m_max.store(value, std::memory_order_relaxed);
+	// Last, so a reader never sees more values counted than in the buckets
+	m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+double Histogram::mean() const
+{
+	const uint64_t n = m_count.load(std::memory_order_acquire);
+	if (n == 0)
+		return 0.0;
+	return static_cast<double>(m_sum.load(std::memory_order_relaxed)) / static_cast<double>(n);
+}
+
+uint64_t Histogram::percentile(double percentile) const
+{
+	const uint64_t n = m_count.load(std::memory_order_acquire);
+	if (n == 0)
+		return 0;
+
+	const auto wanted = static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(n)));
+	const uint64_t target = std::clamp<uint64_t>(wanted, 1, n);
+	uint64_t seen = 0;
+	for (std::size_t i = 0; i < BUCKET_COUNT; i++)
+	{
+		seen += m_buckets[i].load(std::memory_order_relaxed);
+		if (seen >= target)
+			return std::min(bucketUpperBound(i), max());
+	}
+	return max();
+}
+
+HistogramSummary Histogram::summary() const
+{
+	HistogramSummary summary;
+	summary.count = count();
+	summary.p50 = percentile(50.0);
+	summary.p99 = percentile(99.0);
+	summary.p999 = percentile(99.9);
+	summary.max = max();
+	return summary;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Percentiles of a Histogram, cheap to copy across threads.
+ */
+struct HistogramSummary
+{
+	uint64_t count = 0;
+	uint64_t p50 = 0;
+	uint64_t p99 = 0;
+	uint64_t p999 = 0;
+	uint64_t max = 0;
+};
+
+/**
+ * @brief Log-linear histogram of unsigned values, in the spirit of HdrHistogram.
+ *
+ * @details
+ * Values below 32 get a bucket each. Above that every power of two is split into 16 buckets,
+ * so any value is reported within 1/16 (about 6%) of what was recorded, from nanoseconds up to
+ * centuries, in a fixed array of counters. Recording is a few shifts and one counter increment.
+ *
+ * One thread records, any thread may read. Counters are relaxed atomics, so a reader sees a
+ * slightly stale but never torn view. That is good enough for percentiles shown once per second.
+ */
+class Histogram
+{
+  public:
+	static constexpr unsigned SUB_BUCKET_BITS = 5;
+	static constexpr std::size_t SUB_BUCKET_COUNT = std::size_t{1} << SUB_BUCKET_BITS;
+	static constexpr std::size_t SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;
+	static constexpr std::size_t BUCKET_COUNT = SUB_BUCKET_COUNT + (64 - SUB_BUCKET_BITS) * SUB_BUCKET_HALF;
+
+	/**
+	 * @brief Adds a value. Call from a single thread only.
+	 */
+	void record(uint64_t value);
+
+	uint64_t count() const
+	{
+		return m_count.load(std::memory_order_relaxed);
+	}
+
+	uint64_t max() const
+	{
+		return m_max.load(std::memory_order_relaxed);
+	}
+
+	double mean() const;
+
+	/**
+	 * @brief Smallest value that at least @p percentile percent of the recorded values do not exceed,
+	 * rounded up to the end of its bucket.
+	 */
+	uint64_t percentile(double percentile) const;
+
+	HistogramSummary summary() const;
+
+	static std::size_t bucketIndex(uint64_t value);
+	static uint64_t bucketUpperBound(std::size_t index);
+
+  private:
+	std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_buckets{};
+	std::atomic<uint64_t> m_count{0};
+	std::atomic<uint64_t> m_sum{0};
+	std::atomic<uint64_t> m_max{0};
+};
@@ -0,0 +1,289 @@
+#include "injection_worker.hpp"
+
+#include "time_sync.hpp"
+
+#include <QDebug>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <timeapi.h>
+#endif
+
+namespace
+{
+/**
+ * @brief Merges @p next into @p into whatever its edges, keeping the final state of every button.
+ *
+ * A press and release in between are lost, unlike with coalesce_readings(), but nothing stays held.
+ */
+void merge_final_state(vgp_data_exchange_gamepad_reading &into,
+					   const vgp_data_exchange_gamepad_reading &next)
+{
+	const auto down = (into.buttons_down & ~next.buttons_up) | next.buttons_down;
+	const auto up = (into.buttons_up & ~next.buttons_down) | next.buttons_up;
+	into = next;
+	into.buttons_down = down;
+	into.buttons_up = up;
+}
+} // namespace
+
+InjectionWorker::InjectionWorker(std::unique_ptr<ExecutorInterface> executor,
+								 int tickRate,
+								 const low_latency::Options &lowLatency)
+	: m_executor(std::move(executor)),
+	  m_tickInterval(tickRate > 0 ? std::chrono::duration_cast<PlayoutBuffer::Clock::duration>(
+										std::chrono::seconds(1)) /
+										tickRate
+								  : PlayoutBuffer::Clock::duration::zero()),
+	  m_lowLatency(lowLatency)
+{
+}
+
+InjectionWorker::~InjectionWorker()
+{
+	stop();
+}
+
+void InjectionWorker::start()
+{
+	if (m_running.exchange(true))
+		return;
+	if (m_tickInterval > PlayoutBuffer::Clock::duration::zero())
+		m_thread = std::thread(&InjectionWorker::runTicked, this);
+	else
+		m_thread = std::thread(&InjectionWorker::run, this);
+	qDebug() << "Injection thread started";
+}
+
+void InjectionWorker::stop()
+{
+	if (!m_running.exchange(false))
+		return;
+	{
+		std::lock_guard lock(m_wakeMutex);
+		m_wake.notify_one();
+	}
+	if (m_thread.joinable())
+		m_thread.join();
+	// The thread is gone, the executor is ours now
+	for (const QueuedReading &item : m_overflow)
+		inject(item.reading, item.probe);
+	m_overflow.clear();
+	qDebug() << "Injection thread stopped. Injected:" << m_injectedCount.load()
+			 << "Dropped:" << m_droppedCount.load() << "Collapsed:" << m_collapsedCount.load();
+}
+
+bool InjectionWorker::submit(const vgp_data_exchange_gamepad_reading &reading, uint32_t probe)
+{
+	const QueuedReading item{reading, PlayoutBuffer::Clock::now(), probe};
+	// What was held back goes first, so the edges stay in order
+	if (!flushOverflow() || !m_queue.try_push(item)) [[unlikely]]
+	{
+		holdBack(item);
+		return false;
+	}
+	m_queueDepth.record(m_queue.size());
+	wake();
+	return true;
+}
+
+bool InjectionWorker::flushOverflow()
+{
+	if (m_overflow.empty()) [[likely]]
+		return true;
+	std::size_t queued = 0;
+	while (queued < m_overflow.size() && m_queue.try_push(m_overflow[queued]))
+		queued++;
+	if (queued == 0)
+		return false;
+	m_overflow.erase(m_overflow.begin(), m_overflow.begin() + static_cast<std::ptrdiff_t>(queued));
+	wake();
+	return m_overflow.empty();
+}
+
+void InjectionWorker::holdBack(const QueuedReading &item)
+{
+	if (m_overflow.empty())
+		m_overflow.reserve(16);
+	else if (coalesce_readings(m_overflow.back().reading, item.reading))
+	{
+		// Same merge as the injection thread does with a backlog, every edge is kept
+		m_collapsedCount.fetch_add(1, std::memory_order_relaxed);
+		if (item.probe != 0)
+			m_overflow.back().probe = item.probe;
+		m_overflow.back().arrival = item.arrival;
+		return;
+	}
+	else if (m_overflow.size() == OVERFLOW_CAPACITY) [[unlikely]]
+	{
+		// A client tapping faster than anything is injected, bounded rather than growing forever
+		merge_final_state(m_overflow.back().reading, item.reading);
+		if (item.probe != 0)
+			m_overflow.back().probe = item.probe;
+		m_overflow.back().arrival = item.arrival;
+		m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	m_overflow.push_back(item);
+}
+
+void InjectionWorker::wake()
+{
+	// Pairs with the fence in run(): either the consumer sees the new item,
+	// or we see that it went to sleep and wake it up.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_sleeping.load(std::memory_order_relaxed))
+	{
+		std::lock_guard lock(m_wakeMutex);
+		m_wake.notify_one();
+	}
+}
+
+bool InjectionWorker::pollInjectedProbe(uint32_t &probe, int64_t &injectedAt)
+{
+	InjectedProbe injected;
+	if (!m_injectedProbes.try_pop(injected))
+		return false;
+	probe = injected.probe;
+	injectedAt = injected.injectedAt;
+	return true;
+}
+
+void InjectionWorker::inject(const vgp_data_exchange_gamepad_reading &reading, uint32_t probe)
+{
+	const auto start = PlayoutBuffer::Clock::now();
+	try
+	{
+		m_executor->inject_gamepad_state(reading);
+	}
+	catch (const std::exception &e)
+	{
+		qWarning() << "Failed to inject gamepad state:" << e.what();
+	}
+	m_injectedCount.fetch_add(1, std::memory_order_relaxed);
+	m_injectTime.record(static_cast<uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(PlayoutBuffer::Clock::now() - start).count()));
+	if (probe != 0)
+		m_injectedProbes.try_push(InjectedProbe{probe, time_sync::now()}); // Measurement only, fine to lose
+}
+
+void InjectionWorker::tuneThread()
+{
+	if (!m_lowLatency.enabled)
+		return;
+	const low_latency::Report report = low_latency::tuneThread(m_lowLatency);
+	qInfo().noquote() << "Low-latency mode, injection thread:" << report.toString();
+}
+
+void InjectionWorker::run()
+{
+	tuneThread();
+	QueuedReading item;
+	while (true)
+	{
+		if (m_queue.try_pop(item))
+		{
+			vgp_data_exchange_gamepad_reading reading = item.reading;
+			uint32_t probe = item.probe;
+			// Merge whatever piled up meanwhile. Bounded, so a fast producer cannot starve injection.
+			uint64_t collapsed = 0;
+			for (std::size_t i = 1; i < QUEUE_CAPACITY && m_queue.try_pop(item); i++)
+			{
+				if (coalesce_readings(reading, item.reading))
+				{
+					collapsed++;
+					if (item.probe != 0)
+						probe = item.probe;
+					continue;
+				}
+				// Edges that must stay ordered, inject what we have so far first
+				inject(reading, probe);
+				reading = item.reading;
+				probe = item.probe;
+			}
+			inject(reading, probe);
+			if (collapsed != 0)
+				m_collapsedCount.fetch_add(collapsed, std::memory_order_relaxed);
+			continue;
+		}
+
+		// Queue is drained, exit if we were asked to stop
+		if (!m_running.load(std::memory_order_acquire))
+			break;
+
+		m_sleeping.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		{
+			std::unique_lock lock(m_wakeMutex);
+			m_wake.wait(lock,
+						[this]
+						{
+							return !m_queue.empty() || !m_running.load(std::memory_order_acquire);
+						});
+		}
+		m_sleeping.store(false, std::memory_order_relaxed);
+	}
+}
+
+void InjectionWorker::runTicked()
+{
+	tuneThread();
+	using Clock = PlayoutBuffer::Clock;
+
+	PlayoutBuffer playout(m_tickInterval);
+	QueuedReading item;
+	vgp_data_exchange_gamepad_reading reading;
+	uint32_t probe = 0;
+	Clock::time_point nextTick = Clock::now();
+
+#ifdef _WIN32
+	// The default timer resolution of 15.6 ms would make every tick rate above 64 Hz irregular
+	timeBeginPeriod(1);
+#endif
+
+	while (m_running.load(std::memory_order_acquire))
+	{
+		nextTick += m_tickInterval;
+		{
+			// Never woken by submit(), only by the deadline or by stop()
+			std::unique_lock lock(m_wakeMutex);
+			m_wake.wait_until(lock,
+							  nextTick,
+							  [this]
+							  {
+								  return !m_running.load(std::memory_order_acquire);
+							  });
+		}
+
+		// Always drains the queue, a full buffer merges the excess into its newest sample
+		while (m_queue.try_pop(item))
+		{
+			if (playout.push(item.reading, item.arrival, item.probe)) [[likely]]
+				continue;
+			// Edges that must stay ordered behind a full buffer, play the oldest samples out early
+			if (playout.render(Clock::time_point::max(), reading, probe))
+				inject(reading, probe);
+			playout.push(item.reading, item.arrival, item.probe);
+		}
+
+		const Clock::time_point now = Clock::now();
+		if (playout.render(now, reading, probe))
+			inject(reading, probe);
+		m_playoutDelay.store(std::chrono::duration_cast<std::chrono::microseconds>(playout.delay()).count(),
+							 std::memory_order_relaxed);
+
+		// After a stall, resume the cadence from now instead of bursting to catch up
+		if (now - nextTick > m_tickInterval)
+			nextTick = now;
+	}
+
+	// Deliver the edges that are still buffered, so no button stays pressed
+	while (playout.render(Clock::time_point::max(), reading, probe))
+		inject(reading, probe);
+	while (m_queue.try_pop(item))
+		inject(item.reading, item.probe);
+
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "executor.hpp"
+#include "histogram.hpp"
+#include "low_latency.hpp"
+#include "playout_buffer.hpp"
+#include "spsc_queue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Owns an executor and injects gamepad readings on a dedicated thread.
+ *
+ * @details
+ * The network thread hands parsed readings over with submit(),
+ * which only touches a lock-free single-producer/single-consumer queue.
+ * The injection thread drains the queue and calls the executor, so OS input APIs
+ * (SendInput, uinput writes) never run on the GUI or the network thread.
+ *
+ * The injection thread sleeps on a condition variable only when the queue is empty,
+ * the producer signals it only if it is actually asleep.
+ *
+ * If the injection thread falls behind, the backlog is merged with coalesce_readings()
+ * and injected once: sticks jump to their latest position, every button edge is kept.
+ * If it falls so far behind that the queue fills up, the producer holds the readings back instead
+ * of dropping them, merged the same way, and hands them over before anything submitted later.
+ *
+ * With a tick rate, readings are not injected on arrival. The thread wakes at a fixed rate instead
+ * and injects what a PlayoutBuffer renders, trading a few milliseconds for evenly spaced input.
+ * Relative outputs such as the mouse then move once per tick.
+ */
+class InjectionWorker
+{
+  public:
+	static constexpr std::size_t QUEUE_CAPACITY = 256;
+
+	/**
+	 * Readings held back by the producer while the queue is full that could not be merged,
+	 * because their edges must stay ordered. Past that, they are merged into their final state.
+	 */
+	static constexpr std::size_t OVERFLOW_CAPACITY = 1024;
+
+	/**
+	 * @param executor The executor to drive. Constructed by the caller,
+	 * so that device creation errors surface on the caller's thread.
+	 * @param tickRate Injections per second, 0 injects readings as they arrive.
+	 * @param lowLatency Applied to the injection thread when it starts, if enabled.
+	 */
+	explicit InjectionWorker(std::unique_ptr<ExecutorInterface> executor,
+							 int tickRate = 0,
+							 const low_latency::Options &lowLatency = {});
+	~InjectionWorker();
+
+	// Delete copy and move operations, the worker thread holds a pointer to this
+	InjectionWorker(const InjectionWorker &) = delete;
+	InjectionWorker &operator=(const InjectionWorker &) = delete;
+	InjectionWorker(InjectionWorker &&) = delete;
+	InjectionWorker &operator=(InjectionWorker &&) = delete;
+
+	void start();
+
+	/**
+	 * @brief Stops the injection thread after it has drained the queue, then injects what was held back.
+	 */
+	void stop();
+
+	/**
+	 * @brief Queues a reading for injection. Call from a single producer thread only.
+	 *
+	 * A reading is never lost: if the queue is full, it is held back and queued by a later call,
+	 * before anything submitted after it.
+	 *
+	 * @param probe Non-zero to learn when this reading was injected, see pollInjectedProbe().
+	 * @return false if the queue was full and the reading was held back.
+	 */
+	bool submit(const vgp_data_exchange_gamepad_reading &reading, uint32_t probe = 0);
+
+	/**
+	 * @brief Queues the readings held back by submit(), as far as they fit. Call from the producer only.
+	 *
+	 * submit() does it first, call it periodically too for a client that went quiet.
+	 * @return true if nothing is held back anymore.
+	 */
+	bool flushOverflow();
+
+	/**
+	 * @brief Takes the next probe that was injected. Call from the producer thread only.
+	 *
+	 * @param injectedAt Set to the time_sync::now() right after the executor call.
+	 * @return false if no probe was injected since the last call.
+	 */
+	bool pollInjectedProbe(uint32_t &probe, int64_t &injectedAt);
+
+	uint64_t injectedCount() const
+	{
+		return m_injectedCount.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Readings whose edges were merged into their final state, the overflow being full.
+	 */
+	uint64_t droppedCount() const
+	{
+		return m_droppedCount.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Readings that were merged into another one instead of being injected on their own.
+	 */
+	uint64_t collapsedCount() const
+	{
+		return m_collapsedCount.load(std::memory_order_relaxed);
+	}
+
+	std::size_t queueDepth() const
+	{
+		return m_queue.size() + m_overflow.size();
+	}
+
+	/**
+	 * @brief Duration of the executor calls, in nanoseconds.
+	 */
+	const Histogram &injectTime() const
+	{
+		return m_injectTime;
+	}
+
+	/**
+	 * @brief Depth of the queue right after each submit().
+	 */
+	const Histogram &queueDepthHistogram() const
+	{
+		return m_queueDepth;
+	}
+
+	/**
+	 * @brief Current delay of the jitter buffer, zero without a tick rate.
+	 */
+	std::chrono::microseconds playoutDelay() const
+	{
+		return std::chrono::microseconds(m_playoutDelay.load(std::memory_order_relaxed));
+	}
+
+  private:
+	struct QueuedReading
+	{
+		vgp_data_exchange_gamepad_reading reading;
+		PlayoutBuffer::Clock::time_point arrival;
+		uint32_t probe;
+	};
+
+	struct InjectedProbe
+	{
+		uint32_t probe;
+		int64_t injectedAt;
+	};
+
+	void run();
+	void runTicked();
+	void tuneThread();
+	void inject(const vgp_data_exchange_gamepad_reading &reading, uint32_t probe = 0);
+	void holdBack(const QueuedReading &item);
+	void wake();
+
+	std::unique_ptr<ExecutorInterface> m_executor;
+	const PlayoutBuffer::Clock::duration m_tickInterval; // Zero injects on arrival
+	const low_latency::Options m_lowLatency;
+	SpscQueue<QueuedReading, QUEUE_CAPACITY> m_queue;
+	SpscQueue<InjectedProbe, 16> m_injectedProbes; // The other way round, injection thread to producer
+	std::vector<QueuedReading> m_overflow;		   // Producer only, see submit()
+	std::thread m_thread;
+
+	std::atomic<bool> m_running{false};
+	std::atomic<bool> m_sleeping{false};
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wake;
+
+	std::atomic<uint64_t> m_injectedCount{0};
+	std::atomic<uint64_t> m_droppedCount{0};
+	std::atomic<uint64_t> m_collapsedCount{0};
+	std::atomic<int64_t> m_playoutDelay{0}; // Microseconds
+	Histogram m_injectTime;					// Recorded by the injection thread
+	Histogram m_queueDepth;					// Recorded by the producer
+};
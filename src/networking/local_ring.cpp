@@ -0,0 +1,191 @@
+#include "local_ring.hpp"
+
+#ifdef __linux__
+
+#include <QFile>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+/**
+ * How long connect() waits for the offer, a server refusing the client closes the connection instead.
+ */
+constexpr int OFFER_TIMEOUT_S = 3;
+
+QString errorString(int error)
+{
+	return QString::fromLocal8Bit(std::strerror(error));
+}
+} // namespace
+
+local_ring::Producer::~Producer()
+{
+	close();
+}
+
+bool local_ring::Producer::connect(const QString &path, QString &error)
+{
+	close();
+
+	const QByteArray name = QFile::encodeName(path);
+	sockaddr_un address{};
+	if (static_cast<std::size_t>(name.size()) >= sizeof(address.sun_path))
+	{
+		error = QStringLiteral("socket path too long");
+		return false;
+	}
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, name.constData(), static_cast<std::size_t>(name.size()));
+
+	m_socket = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (m_socket < 0 || ::connect(m_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+	{
+		error = errorString(errno);
+		close();
+		return false;
+	}
+	timeval timeout{OFFER_TIMEOUT_S, 0};
+	::setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	Offer offer{};
+	iovec payload{&offer, sizeof(offer)};
+	alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+	msghdr message{};
+	message.msg_iov = &payload;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+	const ssize_t received = ::recvmsg(m_socket, &message, MSG_CMSG_CLOEXEC);
+	const int receiveError = errno;
+
+	int descriptors[2] = {-1, -1}; // The memfd and the eventfd
+	for (cmsghdr *header = CMSG_FIRSTHDR(&message); header != nullptr;
+		 header = CMSG_NXTHDR(&message, header))
+	{
+		if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS &&
+			header->cmsg_len == CMSG_LEN(sizeof(descriptors)))
+		{
+			std::memcpy(descriptors, CMSG_DATA(header), sizeof(descriptors));
+		}
+	}
+	const int memFd = descriptors[0];
+	m_eventFd = descriptors[1];
+
+	if (received != static_cast<ssize_t>(sizeof(offer)) || offer.magic != MAGIC ||
+		offer.version != VERSION || offer.mappingSize != MAPPING_SIZE || memFd < 0 || m_eventFd < 0)
+	{
+		if (received < 0)
+			error = errorString(receiveError);
+		else if (received == 0)
+			error = QStringLiteral("refused by the server");
+		else
+			error = QStringLiteral("the server offered an incompatible ring");
+		if (memFd >= 0)
+			::close(memFd);
+		close();
+		return false;
+	}
+
+	m_mapping = ::mmap(nullptr, MAPPING_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, memFd, 0);
+	::close(memFd); // The mapping keeps the memory
+	if (m_mapping == MAP_FAILED)
+	{
+		m_mapping = nullptr;
+		error = errorString(errno);
+		close();
+		return false;
+	}
+	m_header = static_cast<Header *>(m_mapping);
+	m_slots = static_cast<uint8_t *>(m_mapping) + SLOTS_OFFSET;
+	m_head = m_header->head.load(std::memory_order_relaxed);
+	return true;
+}
+
+bool local_ring::Producer::push(const uint8_t *frame)
+{
+	if (m_header == nullptr) [[unlikely]]
+		return false;
+	if (m_head - m_header->tail.load(std::memory_order_acquire) >= SLOT_COUNT)
+		return false;
+
+	std::memcpy(m_slots + (m_head % SLOT_COUNT) * SLOT_SIZE, frame, compact_frame::FRAME_SIZE);
+	m_head++;
+	// Publishing, then checking whether the server sleeps, pairs with the server setting sleeping,
+	// then checking for frames: one of the two sides always sees the other
+	m_header->head.store(m_head, std::memory_order_seq_cst);
+	if (m_header->sleeping.load(std::memory_order_seq_cst) != 0 && m_header->sleeping.exchange(0) != 0)
+	{
+		const uint64_t one = 1;
+		// Cannot fail, the server reads the counter back to 0 on every wakeup
+		[[maybe_unused]] const ssize_t written = ::write(m_eventFd, &one, sizeof(one));
+		m_wakeups++;
+	}
+	return true;
+}
+
+bool local_ring::Producer::send(const char *data, std::size_t len)
+{
+	return m_socket >= 0 && ::send(m_socket, data, len, MSG_NOSIGNAL) == static_cast<ssize_t>(len);
+}
+
+QByteArray local_ring::Producer::receive()
+{
+	QByteArray result;
+	char buffer[512];
+	ssize_t received = 0;
+	while (m_socket >= 0 && (received = ::recv(m_socket, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0)
+		result.append(buffer, static_cast<qsizetype>(received));
+	return result;
+}
+
+void local_ring::Producer::close()
+{
+	if (m_mapping != nullptr)
+		::munmap(m_mapping, MAPPING_SIZE);
+	if (m_eventFd >= 0)
+		::close(m_eventFd);
+	if (m_socket >= 0)
+		::close(m_socket);
+	m_mapping = nullptr;
+	m_header = nullptr;
+	m_slots = nullptr;
+	m_eventFd = -1;
+	m_socket = -1;
+}
+
+#else
+
+local_ring::Producer::~Producer() = default;
+
+bool local_ring::Producer::connect(const QString &, QString &error)
+{
+	error = QStringLiteral("the local transport is only available on Linux");
+	return false;
+}
+
+bool local_ring::Producer::push(const uint8_t *)
+{
+	return false;
+}
+
+bool local_ring::Producer::send(const char *, std::size_t)
+{
+	return false;
+}
+
+QByteArray local_ring::Producer::receive()
+{
+	return {};
+}
+
+void local_ring::Producer::close()
+{
+}
+
+#endif
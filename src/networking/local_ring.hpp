@@ -0,0 +1,129 @@
+#pragma once
+
+#include "compact_frame.hpp"
+
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file local_ring.hpp
+ * @brief Shared-memory transport for clients on the same machine: emulators, adb forwards, test tools.
+ *
+ * @details
+ * A client connects to the server's Unix domain socket (SOCK_SEQPACKET). The server answers with one
+ * Offer message carrying two descriptors: a memfd holding the ring, and an eventfd.
+ *
+ * The ring is a single-producer single-consumer queue of SLOT_COUNT slots, each holding one compact
+ * frame (see compact_frame.hpp), which needs no handshake on this transport. The client writes a frame
+ * and publishes it by advancing `head`, the server reads it and advances `tail`.
+ *
+ * The server only sleeps on the eventfd after setting `sleeping`, and the client only writes to the
+ * eventfd when it finds `sleeping` set, clearing it. While the server is busy, or spinning in
+ * low-latency mode, the client queues frames without any syscall, and one wakeup drains them all.
+ *
+ * The connection itself carries time_sync control frames both ways, like a TCP connection does,
+ * and closing it ends the session.
+ *
+ * Linux only. Elsewhere, the server cannot listen and Producer::connect() fails.
+ */
+namespace local_ring
+{
+constexpr uint32_t MAGIC = 0x56475052; // "VGPR"
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t SLOT_COUNT = 1024; // A power of two, about 8 s of readings at 120 Hz
+constexpr std::size_t SLOT_SIZE = 32; // One compact frame, padded
+
+static_assert((SLOT_COUNT & (SLOT_COUNT - 1)) == 0);
+static_assert(SLOT_SIZE >= compact_frame::FRAME_SIZE);
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "the ring is shared between processes");
+
+/**
+ * @brief Start of the ring, the slots follow at SLOTS_OFFSET.
+ *
+ * Indices run freely and wrap around at 2^32, the slot of index i is i % SLOT_COUNT.
+ */
+struct Header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slotCount;
+	uint32_t slotSize;
+	alignas(64) std::atomic<uint32_t> head; // Frames written, only the client stores it
+	alignas(64) std::atomic<uint32_t> tail; // Frames read, only the server stores it
+	std::atomic<uint32_t> sleeping;			// 1 while the server waits for the eventfd
+};
+
+constexpr std::size_t SLOTS_OFFSET = (sizeof(Header) + 63) / 64 * 64;
+constexpr std::size_t MAPPING_SIZE = SLOTS_OFFSET + SLOT_COUNT * SLOT_SIZE;
+
+/**
+ * @brief Payload of the message that hands the ring over, with the memfd and the eventfd attached.
+ */
+struct Offer
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t mappingSize;
+};
+
+/**
+ * @brief Client side of the transport.
+ */
+class Producer
+{
+  public:
+	Producer() = default;
+	~Producer();
+
+	// Delete copy and move operations, the mapping and descriptors are owned
+	Producer(const Producer &) = delete;
+	Producer &operator=(const Producer &) = delete;
+	Producer(Producer &&) = delete;
+	Producer &operator=(Producer &&) = delete;
+
+	/**
+	 * @brief Connects to the server listening on @p path and maps the ring it offers.
+	 * @return false with the reason in @p error.
+	 */
+	bool connect(const QString &path, QString &error);
+
+	/**
+	 * @brief Queues a compact frame of FRAME_SIZE bytes, and wakes the server up if it sleeps.
+	 * @return false if the ring is full, the server does not keep up.
+	 */
+	bool push(const uint8_t *frame);
+
+	/**
+	 * @brief Sends a control frame over the connection.
+	 * @return false if the connection is lost.
+	 */
+	bool send(const char *data, std::size_t len);
+
+	/**
+	 * @brief Control frames received since the last call, without waiting.
+	 */
+	QByteArray receive();
+
+	void close();
+
+	/**
+	 * @brief Times push() had to wake the server up.
+	 */
+	uint64_t wakeupCount() const
+	{
+		return m_wakeups;
+	}
+
+  private:
+	int m_socket = -1;
+	int m_eventFd = -1;
+	void *m_mapping = nullptr;
+	Header *m_header = nullptr;
+	uint8_t *m_slots = nullptr;
+	uint32_t m_head = 0;
+	uint64_t m_wakeups = 0;
+};
+} // namespace local_ring
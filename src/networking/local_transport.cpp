@@ -0,0 +1,376 @@
+#include "local_transport.hpp"
+
+#include <QSocketNotifier>
+
+#ifdef __linux__
+
+#include "local_ring.hpp"
+
+#include <QDebug>
+#include <QFile>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/eventfd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+QString errorString(int error)
+{
+	return QString::fromLocal8Bit(std::strerror(error));
+}
+
+sockaddr_un unixAddress(const QByteArray &name)
+{
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, name.constData(), static_cast<std::size_t>(name.size()));
+	return address;
+}
+
+} // namespace
+
+struct LocalTransport::Client
+{
+	int socket = -1;
+	int eventFd = -1;
+	void *mapping = nullptr;
+	local_ring::Header *header = nullptr;
+	const uint8_t *slots = nullptr;
+	uint32_t tail = 0;
+	// Deleted later, a client may be closed from a handler its own notifier called
+	QSocketNotifier *socketNotifier = nullptr;
+	QSocketNotifier *eventNotifier = nullptr;
+
+	~Client()
+	{
+		for (QSocketNotifier *notifier : {socketNotifier, eventNotifier})
+		{
+			if (notifier != nullptr)
+			{
+				notifier->setEnabled(false);
+				notifier->deleteLater();
+			}
+		}
+		if (mapping != nullptr)
+			::munmap(mapping, local_ring::MAPPING_SIZE);
+		if (eventFd >= 0)
+			::close(eventFd);
+		if (socket >= 0)
+			::close(socket);
+	}
+};
+
+LocalTransport::LocalTransport(Handlers handlers) : m_handlers(std::move(handlers))
+{
+}
+
+LocalTransport::~LocalTransport()
+{
+	m_clients.clear();
+	m_listenerNotifier.reset();
+	if (m_listener >= 0)
+	{
+		::close(m_listener);
+		::unlink(QFile::encodeName(m_path).constData());
+	}
+	if (m_lock >= 0)
+		::close(m_lock); // The lock file stays, unlinking it would race with the next server
+}
+
+bool LocalTransport::listen(const QString &path, QString &error)
+{
+	const QByteArray name = QFile::encodeName(path);
+	if (name.isEmpty() || static_cast<std::size_t>(name.size()) >= sizeof(sockaddr_un::sun_path))
+	{
+		error = QStringLiteral("invalid socket path %1").arg(path);
+		return false;
+	}
+
+	// Whoever holds the lock owns the socket file, one left behind by a crashed server is replaced
+	const QByteArray lockName = name + ".lock";
+	m_lock = ::open(lockName.constData(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+	if (m_lock < 0 || ::flock(m_lock, LOCK_EX | LOCK_NB) != 0)
+	{
+		error = errno == EWOULDBLOCK ? QStringLiteral("%1: used by another server").arg(path)
+									 : QStringLiteral("%1: %2").arg(QString::fromLocal8Bit(lockName),
+																	errorString(errno));
+		if (m_lock >= 0)
+			::close(m_lock);
+		m_lock = -1;
+		return false;
+	}
+	::unlink(name.constData());
+
+	m_listener = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	const sockaddr_un address = unixAddress(name);
+	if (m_listener < 0 ||
+		::bind(m_listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+		::chmod(name.constData(), S_IRUSR | S_IWUSR) != 0 || ::listen(m_listener, SOMAXCONN) != 0)
+	{
+		error = QStringLiteral("%1: %2").arg(path, errorString(errno));
+		if (m_listener >= 0)
+			::close(m_listener);
+		m_listener = -1;
+		return false;
+	}
+	m_path = path;
+
+	m_listenerNotifier = std::make_unique<QSocketNotifier>(m_listener, QSocketNotifier::Read);
+	QObject::connect(m_listenerNotifier.get(),
+					 &QSocketNotifier::activated,
+					 [this]()
+					 {
+						 acceptClients();
+					 });
+	return true;
+}
+
+bool LocalTransport::send(quint64 key, const QByteArray &bytes)
+{
+	auto it = m_clients.find(key);
+	if (it == m_clients.end())
+		return false;
+	return ::send(it->second->socket,
+				  bytes.constData(),
+				  static_cast<std::size_t>(bytes.size()),
+				  MSG_DONTWAIT | MSG_NOSIGNAL) == bytes.size();
+}
+
+void LocalTransport::close(quint64 key)
+{
+	m_clients.erase(key);
+}
+
+void LocalTransport::acceptClients()
+{
+	int descriptor = -1;
+	while ((descriptor = ::accept4(m_listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+	{
+		auto client = std::make_unique<Client>();
+		client->socket = descriptor;
+
+		// Sealed, so the client cannot shrink the memory under the server's mapping
+		const int memFd = ::memfd_create("vgamepad-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+		if (memFd < 0 || ::ftruncate(memFd, local_ring::MAPPING_SIZE) != 0 ||
+			::fcntl(memFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0)
+		{
+			qWarning() << "Cannot create the ring of a local client:" << errorString(errno);
+			if (memFd >= 0)
+				::close(memFd);
+			continue;
+		}
+		client->mapping =
+			::mmap(nullptr, local_ring::MAPPING_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, memFd, 0);
+		client->eventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (client->mapping == MAP_FAILED || client->eventFd < 0)
+		{
+			qWarning() << "Cannot create the ring of a local client:" << errorString(errno);
+			if (client->mapping == MAP_FAILED)
+				client->mapping = nullptr;
+			::close(memFd);
+			continue;
+		}
+		client->header = new (client->mapping) local_ring::Header{};
+		client->header->magic = local_ring::MAGIC;
+		client->header->version = local_ring::VERSION;
+		client->header->slotCount = local_ring::SLOT_COUNT;
+		client->header->slotSize = static_cast<uint32_t>(local_ring::SLOT_SIZE);
+		client->header->sleeping.store(1, std::memory_order_relaxed); // Until the first frame
+		client->slots = static_cast<const uint8_t *>(client->mapping) + local_ring::SLOTS_OFFSET;
+
+		ucred credentials{};
+		socklen_t length = sizeof(credentials);
+		::getsockopt(descriptor, SOL_SOCKET, SO_PEERCRED, &credentials, &length);
+		const quint64 key = m_handlers.accepted(credentials.pid);
+		if (key == 0)
+		{
+			::close(memFd);
+			continue; // Refused, the client sees the connection close
+		}
+
+		local_ring::Offer offer{local_ring::MAGIC, local_ring::VERSION, local_ring::MAPPING_SIZE};
+		iovec payload{&offer, sizeof(offer)};
+		alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+		msghdr message{};
+		message.msg_iov = &payload;
+		message.msg_iovlen = 1;
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+		cmsghdr *header = CMSG_FIRSTHDR(&message);
+		header->cmsg_level = SOL_SOCKET;
+		header->cmsg_type = SCM_RIGHTS;
+		header->cmsg_len = CMSG_LEN(2 * sizeof(int));
+		const int descriptors[2] = {memFd, client->eventFd};
+		std::memcpy(CMSG_DATA(header), descriptors, sizeof(descriptors));
+		const bool offered =
+			::sendmsg(descriptor, &message, MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(offer));
+		::close(memFd); // Our mapping and the client's keep the memory
+		if (!offered)
+		{
+			qWarning() << "Cannot offer a ring to a local client:" << errorString(errno);
+			m_handlers.closed(key);
+			continue;
+		}
+
+		client->socketNotifier = new QSocketNotifier(descriptor, QSocketNotifier::Read);
+		QObject::connect(client->socketNotifier,
+						 &QSocketNotifier::activated,
+						 [this, key]()
+						 {
+							 readSocket(key);
+						 });
+		client->eventNotifier = new QSocketNotifier(client->eventFd, QSocketNotifier::Read);
+		QObject::connect(client->eventNotifier,
+						 &QSocketNotifier::activated,
+						 [this, key]()
+						 {
+							 drain(key);
+						 });
+		m_clients.emplace(key, std::move(client));
+	}
+	if (errno != EAGAIN && errno != EWOULDBLOCK)
+		qWarning() << "Cannot accept local clients:" << errorString(errno);
+}
+
+void LocalTransport::readSocket(quint64 key)
+{
+	char buffer[4096];
+	for (;;)
+	{
+		auto it = m_clients.find(key);
+		if (it == m_clients.end())
+			return; // Closed by a handler
+		const ssize_t received = ::recv(it->second->socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+		if (received > 0)
+		{
+			m_handlers.stream(key, buffer, static_cast<std::size_t>(received));
+			continue;
+		}
+		if (received < 0 && errno == EINTR)
+			continue;
+		if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return;
+
+		m_clients.erase(it);
+		m_handlers.closed(key);
+		return;
+	}
+}
+
+void LocalTransport::drain(quint64 key)
+{
+	auto it = m_clients.find(key);
+	if (it == m_clients.end())
+		return;
+	Client &client = *it->second;
+	local_ring::Header &header = *client.header;
+
+	uint64_t signals = 0;
+	// Resets the counter, fails with EAGAIN after a spurious wakeup
+	[[maybe_unused]] const ssize_t drained = ::read(client.eventFd, &signals, sizeof(signals));
+	m_wakeups++;
+
+	uint8_t batch[BATCH_SIZE * compact_frame::FRAME_SIZE];
+	bool spinning = false;
+	Clock::time_point spinEnd;
+	for (;;)
+	{
+		const uint32_t head = header.head.load(std::memory_order_acquire);
+		const uint32_t pending = head - client.tail;
+		if (pending > local_ring::SLOT_COUNT) [[unlikely]]
+		{
+			qWarning() << "Local client of session" << key << "corrupted its ring";
+			m_clients.erase(it);
+			m_handlers.closed(key);
+			return;
+		}
+
+		if (pending > 0)
+		{
+			// Copied out first, the client can write to its slots at any time
+			const auto count = std::min<std::size_t>(pending, BATCH_SIZE);
+			for (std::size_t i = 0; i < count; i++)
+			{
+				const uint32_t index = (client.tail + static_cast<uint32_t>(i)) % local_ring::SLOT_COUNT;
+				const uint8_t *slot = client.slots + index * local_ring::SLOT_SIZE;
+				std::memcpy(batch + i * compact_frame::FRAME_SIZE, slot, compact_frame::FRAME_SIZE);
+			}
+			client.tail += static_cast<uint32_t>(count);
+			header.tail.store(client.tail, std::memory_order_release);
+			m_frames += count;
+			m_handlers.frames(key, batch, count);
+			spinning = false;
+			continue;
+		}
+
+		if (m_spin.count() > 0)
+		{
+			const Clock::time_point now = Clock::now();
+			if (!spinning)
+			{
+				spinning = true;
+				spinEnd = now + m_spin;
+			}
+			if (now < spinEnd)
+				continue;
+		}
+
+		// See Producer::push(), either the client sees the flag or this sees its frame
+		header.sleeping.store(1, std::memory_order_seq_cst);
+		if (header.head.load(std::memory_order_seq_cst) == client.tail)
+			return;
+		header.sleeping.store(0, std::memory_order_relaxed);
+	}
+}
+
+#else
+
+struct LocalTransport::Client
+{
+};
+
+LocalTransport::LocalTransport(Handlers handlers) : m_handlers(std::move(handlers))
+{
+}
+
+LocalTransport::~LocalTransport() = default;
+
+bool LocalTransport::listen(const QString &, QString &error)
+{
+	error = QStringLiteral("the local transport is only available on Linux");
+	return false;
+}
+
+bool LocalTransport::send(quint64, const QByteArray &)
+{
+	return false;
+}
+
+void LocalTransport::close(quint64)
+{
+}
+
+void LocalTransport::acceptClients()
+{
+}
+
+void LocalTransport::readSocket(quint64)
+{
+}
+
+void LocalTransport::drain(quint64)
+{
+}
+
+#endif
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+
+class QSocketNotifier;
+
+/**
+ * @brief Server side of the shared-memory transport of local_ring.hpp.
+ *
+ * @details
+ * Listens on a Unix domain socket. Every client that connects gets a ring and an eventfd of its own,
+ * watched by QSocketNotifiers on the thread that called listen(), so it needs the same event loop as
+ * the Qt sockets. One wakeup drains every frame the client queued meanwhile.
+ *
+ * With a spin time set, the ring is polled that long after it runs empty before sleeping, so a client
+ * sending at a high rate queues its frames without waking the server up at all.
+ */
+class LocalTransport
+{
+  public:
+	/**
+	 * Frames copied out of a ring and handed over at once.
+	 */
+	static constexpr std::size_t BATCH_SIZE = 64;
+
+	struct Handlers
+	{
+		// A client connected, returns the key of its session or 0 to refuse it
+		std::function<quint64(qint64 pid)> accepted;
+		// Compact frames of a key, FRAME_SIZE bytes each, back to back
+		std::function<void(quint64 key, const uint8_t *frames, std::size_t count)> frames;
+		// Control bytes received on the connection of a key
+		std::function<void(quint64 key, const char *data, std::size_t len)> stream;
+		// The client of a key disconnected or broke its ring, it is no longer watched
+		std::function<void(quint64 key)> closed;
+	};
+
+	explicit LocalTransport(Handlers handlers);
+	~LocalTransport();
+
+	// Delete copy and move operations, the notifiers call back into this object
+	LocalTransport(const LocalTransport &) = delete;
+	LocalTransport &operator=(const LocalTransport &) = delete;
+	LocalTransport(LocalTransport &&) = delete;
+	LocalTransport &operator=(LocalTransport &&) = delete;
+
+	/**
+	 * @brief Listens on @p path, replacing a socket file left behind by a server that crashed.
+	 * Only the user running the server may connect.
+	 * @return false with the reason in @p error.
+	 */
+	bool listen(const QString &path, QString &error);
+
+	/**
+	 * @brief How long to poll an empty ring before sleeping, 0 to sleep right away.
+	 */
+	void setSpin(std::chrono::microseconds spin)
+	{
+		m_spin = spin;
+	}
+
+	bool send(quint64 key, const QByteArray &bytes);
+
+	/**
+	 * @brief Disconnects the client of @p key and unmaps its ring.
+	 */
+	void close(quint64 key);
+
+	/**
+	 * @brief Frames received, and wakeups it took.
+	 */
+	uint64_t frameCount() const
+	{
+		return m_frames;
+	}
+	uint64_t wakeupCount() const
+	{
+		return m_wakeups;
+	}
+
+  private:
+	struct Client;
+
+	void acceptClients();
+	void readSocket(quint64 key);
+	void drain(quint64 key);
+
+	Handlers m_handlers;
+	QString m_path;
+	int m_lock = -1; // Lock file next to the socket file
+	int m_listener = -1;
+	std::unique_ptr<QSocketNotifier> m_listenerNotifier;
+	std::map<quint64, std::unique_ptr<Client>> m_clients;
+	std::chrono::microseconds m_spin{0};
+	uint64_t m_frames = 0;
+	uint64_t m_wakeups = 0;
+};
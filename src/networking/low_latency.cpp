@@ -0,0 +1,155 @@
+#include "low_latency.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifndef _WIN32
+QString errorString(int error)
+{
+	return QString::fromLocal8Bit(std::strerror(error));
+}
+
+void setOption(int socket,
+			   int level,
+			   int name,
+			   int value,
+			   const QString &label,
+			   low_latency::Report &report)
+{
+	if (::setsockopt(socket, level, name, &value, sizeof(value)) == 0)
+		report.applied << label;
+	else
+		report.skipped << QStringLiteral("%1 (%2)").arg(label, errorString(errno));
+}
+#endif
+} // namespace
+
+QString low_latency::Report::toString() const
+{
+	QString result = applied.isEmpty() ? QStringLiteral("nothing applied") : applied.join(", ");
+	if (!skipped.isEmpty())
+		result += QStringLiteral("; not applied: ") + skipped.join(", ");
+	return result;
+}
+
+#ifdef _WIN32
+
+low_latency::Report low_latency::tuneThread(const Options &options)
+{
+	Report report;
+	// Time critical is the highest priority outside the real-time priority class of the process
+	const bool critical = options.realtimePriority > 0;
+	const int priority = critical ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST;
+	const QString label = critical ? "priority time critical" : "priority highest";
+	if (SetThreadPriority(GetCurrentThread(), priority))
+		report.applied << label;
+	else
+		report.skipped << QStringLiteral("%1 (error %2)").arg(label).arg(GetLastError());
+
+	if (options.cpu >= 0)
+	{
+		const QString pin = QStringLiteral("pinned to CPU %1").arg(options.cpu);
+		if (options.cpu < 64 && SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << options.cpu) != 0)
+			report.applied << pin;
+		else
+			report.skipped << QStringLiteral("%1 (error %2)").arg(pin).arg(GetLastError());
+	}
+	return report;
+}
+
+low_latency::Report low_latency::tuneSocket(qintptr, bool, const Options &)
+{
+	// Windows ignores IP_TOS from applications, marking takes a QoS policy set by the administrator
+	Report report;
+	report.skipped << QStringLiteral("socket tuning (not supported on Windows)");
+	return report;
+}
+
+#else
+
+low_latency::Report low_latency::tuneThread(const Options &options)
+{
+	Report report;
+
+	bool realtime = false;
+	if (options.realtimePriority > 0)
+	{
+		sched_param param{};
+		param.sched_priority = options.realtimePriority;
+		const QString label = QStringLiteral("SCHED_FIFO priority %1").arg(options.realtimePriority);
+		const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if (error == 0)
+		{
+			report.applied << label;
+			realtime = true;
+		}
+		else
+			report.skipped << QStringLiteral("%1 (%2)").arg(label, errorString(error));
+	}
+	if (!realtime)
+	{
+		// On Linux, the nice level of a thread id only applies to that thread
+		const QString label = QStringLiteral("nice %1").arg(NICE_LEVEL);
+		if (setpriority(PRIO_PROCESS, static_cast<id_t>(gettid()), NICE_LEVEL) == 0)
+			report.applied << label;
+		else
+			report.skipped << QStringLiteral("%1 (%2)").arg(label, errorString(errno));
+	}
+
+	if (options.cpu >= 0)
+	{
+		const QString label = QStringLiteral("pinned to CPU %1").arg(options.cpu);
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		int error = EINVAL;
+		if (options.cpu < CPU_SETSIZE)
+		{
+			CPU_SET(options.cpu, &cpus);
+			error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+		}
+		if (error == 0)
+			report.applied << label;
+		else
+			report.skipped << QStringLiteral("%1 (%2)").arg(label, errorString(error));
+	}
+	return report;
+}
+
+low_latency::Report low_latency::tuneSocket(qintptr descriptor, bool stream, const Options &options)
+{
+	Report report;
+	const int socket = static_cast<int>(descriptor);
+	setOption(socket, SOL_SOCKET, SO_PRIORITY, SOCKET_PRIORITY, QStringLiteral("SO_PRIORITY"), report);
+	setOption(socket, IPPROTO_IP, IP_TOS, TYPE_OF_SERVICE, QStringLiteral("DSCP EF"), report);
+	if (stream)
+	{
+		// Not permanent, the kernel may go back to delayed acks, but it starts the connection without
+		setOption(socket, IPPROTO_TCP, TCP_QUICKACK, 1, QStringLiteral("TCP_QUICKACK"), report);
+	}
+	if (options.busyPollUs > 0)
+	{
+		// Raising it above net.core.busy_read takes CAP_NET_ADMIN
+		setOption(socket,
+				  SOL_SOCKET,
+				  SO_BUSY_POLL,
+				  options.busyPollUs,
+				  QStringLiteral("SO_BUSY_POLL %1 us").arg(options.busyPollUs),
+				  report);
+	}
+	return report;
+}
+
+#endif
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QtGlobal>
+
+/**
+ * @file low_latency.hpp
+ * @brief Optional scheduling and socket tuning of the input path, the "low-latency mode".
+ *
+ * @details
+ * The network thread and the injection threads can run in a real-time scheduling class, or at least
+ * at a raised priority, pinned to one CPU, so a busy desktop does not delay them by a time slice.
+ * Client sockets can be marked as interactive traffic (socket priority and DSCP Expedited
+ * Forwarding), acknowledge segments right away and busy poll the network device.
+ *
+ * Everything is best effort: without the privileges for a step (CAP_SYS_NICE, RLIMIT_RTPRIO,
+ * CAP_NET_ADMIN on Linux) it is skipped, and the Report says what was applied and what was not.
+ * The kernel throttles real-time threads that never sleep, so a bug cannot lock up the machine.
+ */
+namespace low_latency
+{
+/**
+ * nice level asked for when real-time scheduling is off or not permitted.
+ */
+constexpr int NICE_LEVEL = -10;
+
+/**
+ * SO_PRIORITY of client sockets, the highest one allowed without CAP_NET_ADMIN.
+ */
+constexpr int SOCKET_PRIORITY = 6;
+
+/**
+ * IP_TOS of client sockets: DSCP 46, Expedited Forwarding.
+ */
+constexpr int TYPE_OF_SERVICE = 46 << 2;
+
+struct Options
+{
+	bool enabled = false;
+	int realtimePriority = 10; // SCHED_FIFO priority from 1 to 99, 0 only raises the nice level
+	int cpu = -1;			   // CPU the input threads are pinned to, -1 for none
+	int busyPollUs = 50;	   // SO_BUSY_POLL of client sockets, 0 for none
+};
+
+/**
+ * @brief What a tuning step applied, and what it did not with the reason.
+ */
+struct Report
+{
+	QStringList applied;
+	QStringList skipped;
+
+	QString toString() const;
+};
+
+/**
+ * @brief Tunes the scheduling of the calling thread as far as permitted.
+ */
+Report tuneThread(const Options &options);
+
+/**
+ * @brief Tunes a client socket, or the UDP socket shared by every client.
+ * @param stream true for a TCP connection.
+ */
+Report tuneSocket(qintptr descriptor, bool stream, const Options &options);
+} // namespace low_latency
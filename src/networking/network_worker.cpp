@@ -0,0 +1,531 @@
+#include "network_worker.hpp"
+
+#include <QHostAddress>
+#include <functional>
+#include <vector>
+
+namespace
+{
+/**
+ * @brief Whether a datagram of an unknown peer opens a session: a reading, or the hello sent before any.
+ */
+bool opensSession(const uint8_t *datagram, std::size_t size)
+{
+	udp_frame::Frame probe;
+	if (udp_frame::decode(datagram, size, probe))
+		return true;
+
+	time_sync::Message message;
+	std::size_t consumed = 0;
+	return time_sync::decode(reinterpret_cast<const char *>(datagram), size, message, consumed) ==
+			   time_sync::DecodeResult::Ok &&
+		   message.kind == time_sync::Message::Kind::Hello;
+}
+
+/**
+ * @brief Hands every accepted connection over as a bare descriptor, for the io_uring path.
+ */
+class DescriptorServer : public QTcpServer
+{
+  public:
+	DescriptorServer(std::function<void(qintptr)> accepted, QObject *parent)
+		: QTcpServer(parent), m_accepted(std::move(accepted))
+	{
+	}
+
+  protected:
+	void incomingConnection(qintptr socketDescriptor) override
+	{
+		m_accepted(socketDescriptor);
+	}
+
+  private:
+	std::function<void(qintptr)> m_accepted;
+};
+} // namespace
+
+ServerConfig ServerConfig::fromSettings()
+{
+	const auto &settings = SettingsSingleton::instance();
+	ServerConfig config;
+	config.port = settings.port();
+	config.transport = settings.transport();
+	config.injectionRate = settings.injectionRate();
+	config.stallTimeoutMs = settings.stallTimeout();
+	config.executorType = settings.executorType();
+	return config;
+}
+
+NetworkWorker::NetworkWorker(QObject *parent) : QObject(parent)
+{
+}
+
+NetworkWorker::~NetworkWorker()
+{
+	// Normally already emptied by stop() on the network thread
+	sessions.clear();
+}
+
+void NetworkWorker::startListening(const ServerConfig &serverConfig)
+{
+	config = serverConfig;
+	if (!config.capturePath.isEmpty() && !capture.open(config.capturePath))
+	{
+		emit listenFailed(
+			tr("Cannot open the capture file %1: %2").arg(config.capturePath, capture.errorString()));
+		return;
+	}
+	if (config.lowLatency.enabled)
+	{
+		const low_latency::Report report = low_latency::tuneThread(config.lowLatency);
+		qInfo().noquote() << "Low-latency mode, network thread:" << report.toString();
+	}
+	if (config.ioUring)
+		openUring();
+	if (!config.localSocket.isEmpty() && !listenLocal(config.localSocket))
+		return;
+	bool started = config.transport == TransportMode::Udp ? listenUdp(config.port) : listenTcp(config.port);
+	if (!started)
+		return;
+
+	statsTimer = new QTimer(this);
+	connect(statsTimer, &QTimer::timeout, this, &NetworkWorker::publishStats);
+	statsTimer->start(STATS_INTERVAL_MS);
+
+	// A coarse timer could fire up to 5% late, too much for a 150 ms heartbeat timeout
+	watchdogTimer = new QTimer(this);
+	watchdogTimer->setTimerType(Qt::PreciseTimer);
+	connect(watchdogTimer, &QTimer::timeout, this, &NetworkWorker::checkStalls);
+	watchdogTimer->start(WATCHDOG_INTERVAL_MS);
+
+	// After listening, a client connecting meanwhile only waits for its own executor
+	try
+	{
+		DevicePool::instance().reserve(config.executorType, config.pooledDevices);
+	}
+	catch (const std::exception &e)
+	{
+		qWarning() << "Cannot create the input devices ahead of time:" << e.what();
+	}
+}
+
+bool NetworkWorker::listenTcp(quint16 port)
+{
+	qInfo() << "Starting TCP server initialization";
+
+	if (uring)
+	{
+		tcpServer = new DescriptorServer(
+			[this](qintptr descriptor)
+			{
+				acceptDescriptor(descriptor);
+			},
+			this);
+	}
+	else
+		tcpServer = new QTcpServer(this);
+	tcpServer->setListenBacklogSize(static_cast<int>(MAX_SESSIONS));
+
+	if (!tcpServer->listen(QHostAddress::AnyIPv4, port))
+	{
+		emit listenFailed(tcpServer->errorString());
+		tcpServer->close();
+		return false;
+	}
+	connect(tcpServer, &QTcpServer::newConnection, this, &NetworkWorker::handleConnection);
+
+	qInfo() << "Server started successfully on port:" << tcpServer->serverPort();
+	emit listening(tcpServer->serverPort());
+	return true;
+}
+
+bool NetworkWorker::listenUdp(quint16 port)
+{
+	qInfo() << "Starting UDP server initialization";
+
+	if (uring)
+	{
+		QString error;
+		if (!uring->listenDatagrams(QHostAddress::AnyIPv4, port, error))
+		{
+			emit listenFailed(error);
+			return false;
+		}
+		tuneSocket(uring->datagramDescriptor(), false, "UDP socket");
+		qInfo() << "UDP server started successfully on port:" << uring->datagramPort();
+		emit listening(uring->datagramPort());
+		return true;
+	}
+
+	udpSocket = new QUdpSocket(this);
+	if (!udpSocket->bind(QHostAddress::AnyIPv4, port))
+	{
+		emit listenFailed(udpSocket->errorString());
+		udpSocket->close();
+		return false;
+	}
+	connect(udpSocket, &QUdpSocket::readyRead, this, &NetworkWorker::serveDatagrams);
+	tuneSocket(udpSocket->socketDescriptor(), false, "UDP socket");
+
+	qInfo() << "UDP server started successfully on port:" << udpSocket->localPort();
+	emit listening(udpSocket->localPort());
+	return true;
+}
+
+bool NetworkWorker::listenLocal(const QString &path)
+{
+	LocalTransport::Handlers handlers;
+	handlers.accepted = [this](qint64 pid) -> quint64
+	{
+		ClientSession *session = openSession(tr("Local client, process %1").arg(pid));
+		if (session == nullptr)
+			return 0;
+		const quint64 sessionId = session->id();
+		session->setReplyChannel(
+			[this, sessionId](const QByteArray &bytes)
+			{
+				local->send(sessionId, bytes);
+			});
+		qInfo() << "New local client connection received";
+		return sessionId;
+	};
+	handlers.frames = [this](quint64 sessionId, const uint8_t *frames, std::size_t count)
+	{
+		auto it = sessions.find(sessionId);
+		if (it != sessions.end())
+			it->second->receiveFrames(frames, count);
+	};
+	handlers.stream = [this](quint64 sessionId, const char *data, std::size_t len)
+	{
+		auto it = sessions.find(sessionId);
+		if (it != sessions.end() && !it->second->receiveStream(data, len))
+			closeSession(sessionId); // Flooding or garbage
+	};
+	handlers.closed = [this](quint64 sessionId)
+	{
+		qInfo() << "Local client disconnected.";
+		closeSession(sessionId);
+	};
+
+	local = std::make_unique<LocalTransport>(std::move(handlers));
+	// Polling an empty ring a little longer spares the wakeups of a client sending at a high rate
+	if (config.lowLatency.enabled)
+		local->setSpin(std::chrono::microseconds(config.lowLatency.busyPollUs));
+	QString error;
+	if (!local->listen(path, error))
+	{
+		local.reset();
+		emit listenFailed(error);
+		return false;
+	}
+	qInfo().noquote() << "Local clients accepted on" << path;
+	return true;
+}
+
+void NetworkWorker::stop()
+{
+	if (statsTimer != nullptr)
+		statsTimer->stop();
+	if (watchdogTimer != nullptr)
+		watchdogTimer->stop();
+	// IMPORTANT: client sockets should not be accessed when the server is closed
+	while (!sessions.empty())
+		closeSession(sessions.begin()->first);
+	if (tcpServer != nullptr)
+		tcpServer->close(); // And then close the server
+	if (udpSocket != nullptr)
+		udpSocket->close();
+	if (uring)
+	{
+		qInfo() << "io_uring handled" << uring->completionCount() << "completions in"
+				<< uring->wakeupCount() << "wakeups";
+		uring.reset(); // Closes its sockets
+	}
+	if (local)
+	{
+		qInfo() << "Local clients sent" << local->frameCount() << "frames in" << local->wakeupCount()
+				<< "wakeups";
+		local.reset(); // Removes the socket file
+	}
+	capture.close();
+}
+
+void NetworkWorker::tuneSocket(qintptr descriptor, bool stream, const QString &what)
+{
+	if (!config.lowLatency.enabled)
+		return;
+	const low_latency::Report report = low_latency::tuneSocket(descriptor, stream, config.lowLatency);
+	qInfo().noquote() << "Low-latency mode," << what + ":" << report.toString();
+}
+
+void NetworkWorker::openUring()
+{
+	UringReceiver::Handlers handlers;
+	handlers.stream = [this](quint64 sessionId, const char *data, std::size_t len)
+	{
+		auto it = sessions.find(sessionId);
+		if (it != sessions.end() && !it->second->receiveStream(data, len))
+			closeSession(sessionId); // Flooding or garbage
+	};
+	handlers.streamClosed = [this](quint64 sessionId)
+	{
+		qInfo() << "Device disconnected.";
+		closeSession(sessionId);
+	};
+	handlers.datagram =
+		[this](const QHostAddress &sender, quint16 senderPort, const uint8_t *data, std::size_t len)
+	{
+		dispatchDatagram(sender, senderPort, data, len);
+	};
+
+	auto receiver = std::make_unique<UringReceiver>(std::move(handlers));
+	QString error;
+	if (!receiver->open(error))
+	{
+		qWarning().noquote() << "Cannot receive through io_uring:" << error << "- using Qt sockets";
+		return;
+	}
+	uring = std::move(receiver);
+	qInfo() << "Receiving through io_uring";
+}
+
+ClientSession *NetworkWorker::openSession(const QString &description)
+{
+	if (sessions.size() >= MAX_SESSIONS)
+	{
+		qWarning() << "Refusing client, already serving" << MAX_SESSIONS << "sessions";
+		return nullptr;
+	}
+
+	std::unique_ptr<ExecutorInterface> executor;
+	try
+	{
+		executor = DevicePool::instance().lease(config.executorType);
+	}
+	catch (const std::exception &e)
+	{
+		qCritical() << "Failed to create executor for a new client:" << e.what();
+		emit sessionFailed(QString::fromUtf8(e.what()));
+		return nullptr;
+	}
+
+	quint64 sessionId = nextSessionId++;
+	auto session = std::make_unique<ClientSession>(sessionId,
+												   description,
+												   std::move(executor),
+												   config.injectionRate,
+												   config.lowLatency);
+	ClientSession *opened = session.get();
+	opened->setStallTimeout(config.stallTimeoutMs);
+	if (capture.isOpen())
+		opened->setCapture(&capture);
+	sessions.emplace(sessionId, std::move(session));
+
+	qInfo().noquote() << "Session" << sessionId << "opened:" << description;
+	emit clientConnected(sessionId, description);
+	return opened;
+}
+
+void NetworkWorker::closeSession(quint64 sessionId)
+{
+	auto it = sessions.find(sessionId);
+	if (it == sessions.end())
+		return;
+
+	if (uring)
+		uring->closeStream(sessionId);
+	if (local)
+		local->close(sessionId);
+	if (auto socketIt = sessionSockets.find(sessionId); socketIt != sessionSockets.end())
+	{
+		QTcpSocket *socket = socketIt->second;
+		socket->disconnect(this);
+		socket->close(); // Close the connection gracefully
+		socket->deleteLater();
+		sessionSockets.erase(socketIt);
+	}
+
+	emit statsUpdated(sessionId, it->second->snapshot());
+	sessions.erase(it); // Joins the injection thread and releases the virtual devices
+	emit clientDisconnected(sessionId);
+}
+
+void NetworkWorker::handleConnection()
+{
+	while (tcpServer->hasPendingConnections())
+	{
+		QTcpSocket *socket = tcpServer->nextPendingConnection();
+		// disable Nagle's algorithm to avoid delay and bunching of small packages
+		socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+		tuneSocket(socket->socketDescriptor(), true, "client socket");
+		QString connectionMessage =
+			tr("Connected to %1 at `%2 : %3`")
+				.arg(socket->peerName().isEmpty() ? "Unknown device" : socket->peerName(),
+					 socket->peerAddress().toString(),
+					 QString::number(socket->peerPort()));
+
+		ClientSession *session = openSession(connectionMessage);
+		if (session == nullptr)
+		{
+			socket->abort();
+			socket->deleteLater();
+			continue;
+		}
+
+		serveSocket(socket, session);
+		qInfo() << "New client connection received";
+	}
+}
+
+void NetworkWorker::serveSocket(QTcpSocket *socket, ClientSession *session)
+{
+	quint64 sessionId = session->id();
+	sessionSockets.emplace(sessionId, socket);
+	session->setReplyChannel(
+		[socket](const QByteArray &bytes)
+		{
+			socket->write(bytes);
+		});
+	connect(socket,
+			&QAbstractSocket::readyRead,
+			this,
+			[session, socket]()
+			{
+				if (!session->readStream(socket))
+					socket->abort(); // Flooding or garbage, emits disconnected
+			});
+	connect(socket,
+			&QAbstractSocket::disconnected,
+			this,
+			[this, sessionId]()
+			{
+				qInfo() << "Device disconnected.";
+				closeSession(sessionId);
+			});
+}
+
+void NetworkWorker::acceptDescriptor(qintptr descriptor)
+{
+	QHostAddress peer;
+	quint16 peerPort = 0;
+	UringReceiver::peerAddress(descriptor, peer, peerPort);
+	tuneSocket(descriptor, true, "client socket");
+	QString connectionMessage = tr("Connected to %1 at `%2 : %3`")
+									.arg("Unknown device", peer.toString(), QString::number(peerPort));
+
+	ClientSession *session = openSession(connectionMessage);
+	if (session == nullptr)
+	{
+		auto *socket = new QTcpSocket(this);
+		socket->setSocketDescriptor(descriptor);
+		socket->abort();
+		socket->deleteLater();
+		return;
+	}
+
+	quint64 sessionId = session->id();
+	if (uring->watchStream(descriptor, sessionId))
+	{
+		session->setReplyChannel(
+			[receiver = uring.get(), sessionId](const QByteArray &bytes)
+			{
+				receiver->sendStream(sessionId, bytes);
+			});
+	}
+	else
+	{
+		qWarning() << "Cannot receive from session" << sessionId << "through io_uring, using a Qt socket";
+		auto *socket = new QTcpSocket(this);
+		socket->setSocketDescriptor(descriptor);
+		socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+		serveSocket(socket, session);
+	}
+	qInfo() << "New client connection received";
+}
+
+void NetworkWorker::serveDatagrams()
+{
+	// One byte more than we accept, so oversized datagrams are detected instead of truncated
+	uint8_t datagram[udp_frame::MAX_DATAGRAM_SIZE + 1];
+
+	while (udpSocket->hasPendingDatagrams())
+	{
+		QHostAddress sender;
+		quint16 senderPort = 0;
+		qint64 size = udpSocket->readDatagram(reinterpret_cast<char *>(datagram),
+											  sizeof(datagram),
+											  &sender,
+											  &senderPort);
+		if (size < 0)
+			break;
+
+		dispatchDatagram(sender, senderPort, datagram, static_cast<std::size_t>(size));
+	}
+}
+
+void NetworkWorker::dispatchDatagram(const QHostAddress &sender,
+									  quint16 senderPort,
+									  const uint8_t *datagram,
+									  std::size_t size)
+{
+	ClientSession *session = nullptr;
+	for (const auto &[id, candidate] : sessions)
+	{
+		if (candidate->udpPeerPort == senderPort && candidate->udpPeer == sender)
+		{
+			session = candidate.get();
+			break;
+		}
+	}
+
+	if (session == nullptr)
+	{
+		// Only a valid frame or a hello opens a session, stray datagrams are ignored
+		if (!opensSession(datagram, size))
+			return;
+		session = openSession(tr("Receiving from `%1 : %2` over UDP")
+								  .arg(sender.toString(), QString::number(senderPort)));
+		if (session == nullptr)
+			return;
+		session->udpPeer = sender;
+		session->udpPeerPort = senderPort;
+		session->setReplyChannel(
+			[this, sender, senderPort](const QByteArray &bytes)
+			{
+				sendDatagram(bytes, sender, senderPort);
+			});
+	}
+
+	session->receiveDatagram(datagram, size);
+}
+
+void NetworkWorker::sendDatagram(const QByteArray &bytes, const QHostAddress &receiver, quint16 port)
+{
+	if (uring)
+		uring->sendDatagram(bytes, receiver, port);
+	else
+		udpSocket->writeDatagram(bytes, receiver, port);
+}
+
+void NetworkWorker::publishStats()
+{
+	std::vector<quint64> expired;
+	for (const auto &[id, session] : sessions)
+	{
+		session->flushEchoes();
+		emit statsUpdated(id, session->snapshot());
+		if (session->udpPeerPort != 0 && session->idleTime() > UDP_IDLE_TIMEOUT_MS)
+			expired.push_back(id);
+	}
+	for (quint64 id : expired)
+	{
+		qInfo() << "UDP session" << id << "timed out";
+		closeSession(id);
+	}
+}
+
+void NetworkWorker::checkStalls()
+{
+	for (const auto &[id, session] : sessions)
+		session->checkStall();
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "../settings/settings_singleton.hpp"
+#include "capture.hpp"
+#include "client_session.hpp"
+#include "device_pool.hpp"
+#include "local_transport.hpp"
+#include "low_latency.hpp"
+#include "session_stats.hpp"
+#include "uring_receiver.hpp"
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUdpSocket>
+#include <map>
+#include <memory>
+
+/**
+ * @brief What the network thread needs to know to serve clients.
+ */
+struct ServerConfig
+{
+	quint16 port = SettingsSingleton::DEFAULT_PORT_NUMBER;
+	TransportMode transport = SettingsSingleton::DEFAULT_TRANSPORT;
+	int injectionRate = SettingsSingleton::DEFAULT_INJECTION_RATE;
+	int stallTimeoutMs = SettingsSingleton::DEFAULT_STALL_TIMEOUT; // See ClientSession::setStallTimeout()
+	ExecutorType executorType = SettingsSingleton::DEFAULT_EXECUTOR_TYPE;
+	QString capturePath;			 // Records every received byte to this file for replay, empty for none
+	bool ioUring = false;			 // Receive through io_uring where available, see UringReceiver
+	low_latency::Options lowLatency; // Network and injection threads, client sockets
+	QString localSocket;			 // Also serves local clients on this socket, see local_ring.hpp
+
+	// Idle executors the DevicePool keeps for reconnects, 0 creates new devices for every session
+	std::size_t pooledDevices = DevicePool::DEFAULT_CAPACITY;
+
+	/**
+	 * @brief Reads the configuration from the settings. Call from the GUI thread.
+	 */
+	static ServerConfig fromSettings();
+};
+
+/**
+ * @brief Receives and parses gamepad readings of every client on the network thread.
+ *
+ * @details
+ * Lives on its own QThread (see Server). Creates its sockets in startListening(),
+ * so they belong to that thread and `readyRead` is never delayed by the GUI event loop.
+ *
+ * Up to MAX_SESSIONS clients are served at once. Each one gets a ClientSession with its own
+ * executor and injection thread, so the only shared work is reading the sockets and parsing,
+ * which takes microseconds per reading.
+ *
+ * With TransportMode::Udp, sessions are keyed by the peer address and port.
+ * UDP has no disconnect, a session that stays silent for UDP_IDLE_TIMEOUT_MS is closed.
+ * See udp_frame.hpp for the datagram format.
+ *
+ * Every WATCHDOG_INTERVAL_MS, sessions that went silent while holding inputs get them released,
+ * see ClientSession::checkStall().
+ *
+ * With ServerConfig::ioUring set, the sockets are read through a UringReceiver instead of Qt's
+ * event dispatcher, if the build and the kernel support it. Otherwise the Qt sockets are used.
+ *
+ * With ServerConfig::localSocket set, clients on the same machine can also connect to that Unix domain
+ * socket and send their readings through shared memory, see local_ring.hpp and LocalTransport.
+ *
+ * With ServerConfig::lowLatency enabled, the network thread, the injection threads and the client
+ * sockets are tuned as far as permitted, and what was applied is logged, see low_latency.hpp.
+ *
+ * Executors are leased from the DevicePool, which keeps up to ServerConfig::pooledDevices of them
+ * created, so a client reconnecting gets the same virtual devices back right away.
+ *
+ * With ServerConfig::capturePath set, every received byte is recorded with its arrival time,
+ * see capture.hpp and CaptureReplayer.
+ *
+ * The GUI only learns about sessions through signals:
+ * connection changes and a periodic SessionStats snapshot per session.
+ */
+class NetworkWorker : public QObject
+{
+	Q_OBJECT
+
+  signals:
+	void listening(quint16 port);
+	void listenFailed(const QString &error);
+	void clientConnected(quint64 sessionId, const QString &description);
+	void clientDisconnected(quint64 sessionId);
+	void sessionFailed(const QString &error);
+	void statsUpdated(quint64 sessionId, const SessionStats &stats);
+
+  public:
+	/**
+	 * Interval between two SessionStats snapshots.
+	 */
+	static constexpr int STATS_INTERVAL_MS = 1000;
+
+	/**
+	 * Maximum number of concurrent clients. Further connections are refused.
+	 */
+	static constexpr std::size_t MAX_SESSIONS = 16;
+
+	static constexpr qint64 UDP_IDLE_TIMEOUT_MS = 10000;
+
+	/**
+	 * Interval between two stall checks, the resolution of the stall timeouts.
+	 */
+	static constexpr int WATCHDOG_INTERVAL_MS = 10;
+
+	explicit NetworkWorker(QObject *parent = nullptr);
+	~NetworkWorker() override;
+
+	/**
+	 * @brief Opens the server socket. Must run on the network thread.
+	 */
+	void startListening(const ServerConfig &config);
+
+  public slots:
+	/**
+	 * @brief Closes every session and the server socket.
+	 * Must run on the network thread.
+	 */
+	void stop();
+
+  private slots:
+	void handleConnection();
+	void serveDatagrams();
+	void publishStats();
+	void checkStalls();
+
+  private:
+	bool listenTcp(quint16 port);
+	bool listenUdp(quint16 port);
+	bool listenLocal(const QString &path);
+	void openUring();
+	void tuneSocket(qintptr descriptor, bool stream, const QString &what);
+
+	/**
+	 * @brief Wires an accepted connection to its session.
+	 */
+	void serveSocket(QTcpSocket *socket, ClientSession *session);
+
+	/**
+	 * @brief Opens a session for a connection accepted on the io_uring path.
+	 */
+	void acceptDescriptor(qintptr descriptor);
+
+	/**
+	 * @brief Hands a datagram to the session of its sender, opening one if needed.
+	 */
+	void dispatchDatagram(const QHostAddress &sender,
+						  quint16 senderPort,
+						  const uint8_t *datagram,
+						  std::size_t size);
+	void sendDatagram(const QByteArray &bytes, const QHostAddress &receiver, quint16 port);
+
+	/**
+	 * @brief Creates a session with an executor leased from the DevicePool.
+	 * @return nullptr if the limit is reached or the executor cannot be created.
+	 */
+	ClientSession *openSession(const QString &description);
+	void closeSession(quint64 sessionId);
+
+	ServerConfig config;
+	QTcpServer *tcpServer = nullptr;
+	QUdpSocket *udpSocket = nullptr;
+	QTimer *statsTimer = nullptr;
+	QTimer *watchdogTimer = nullptr;
+	CaptureWriter capture;
+
+	quint64 nextSessionId = 1;
+	std::map<quint64, std::unique_ptr<ClientSession>> sessions;
+	std::map<quint64, QTcpSocket *> sessionSockets; // TCP sessions only
+	std::unique_ptr<UringReceiver> uring;			// Only while receiving through io_uring
+	std::unique_ptr<LocalTransport> local;			// Only while serving local clients
+};
@@ -0,0 +1,127 @@
+#include "playout_buffer.hpp"
+
+#include "executor.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+using Micros = std::chrono::duration<double, std::micro>;
+
+// Weight of a new interval in the running estimates, as in RFC 3550 jitter
+constexpr double ESTIMATE_GAIN = 1.0 / 16.0;
+
+// How many mean deviations of jitter the delay absorbs
+constexpr double JITTER_MARGIN = 4.0;
+
+float lerp(float from, float to, double alpha)
+{
+	return static_cast<float>(from + (to - from) * alpha);
+}
+} // namespace
+
+PlayoutBuffer::PlayoutBuffer(Clock::duration tick) : m_tick(tick), m_delay(tick)
+{
+}
+
+bool PlayoutBuffer::push(const vgp_data_exchange_gamepad_reading &reading,
+						 Clock::time_point arrival,
+						 uint32_t probe)
+{
+	if (full()) [[unlikely]]
+	{
+		// Like the backlog of the injection queue: the sticks take the latest position, edges add up
+		Sample &newest = m_samples[(m_head + m_count - 1) % CAPACITY];
+		if (!coalesce_readings(newest.reading, reading))
+			return false;
+		newest.arrival = arrival;
+		if (probe != 0)
+			newest.probe = probe;
+		updateDelay(arrival);
+		return true;
+	}
+
+	updateDelay(arrival);
+	m_samples[(m_head + m_count) % CAPACITY] = Sample{reading, arrival, probe};
+	m_count++;
+	return true;
+}
+
+bool PlayoutBuffer::render(Clock::time_point now, vgp_data_exchange_gamepad_reading &out, uint32_t &probe)
+{
+	probe = 0;
+	const Clock::time_point target = now - m_delay;
+
+	// Play out every sample that is due, collecting their button edges
+	uint32_t buttonsDown = 0;
+	uint32_t buttonsUp = 0;
+	bool advanced = false;
+	while (m_count > 0)
+	{
+		const Sample &sample = m_samples[m_head];
+		if (sample.arrival > target)
+			break;
+		// Keep the press and the release of a button in separate injections
+		if ((buttonsDown & sample.reading.buttons_up) != 0 ||
+			(buttonsUp & sample.reading.buttons_down) != 0)
+			break;
+		buttonsDown |= sample.reading.buttons_down;
+		buttonsUp |= sample.reading.buttons_up;
+		if (sample.probe != 0)
+			probe = sample.probe;
+		m_base = sample;
+		m_hasBase = true;
+		advanced = true;
+		m_head = (m_head + 1) % CAPACITY;
+		m_count--;
+	}
+
+	if (!m_hasBase)
+		return false;
+
+	out = m_base.reading;
+	out.buttons_down = buttonsDown;
+	out.buttons_up = buttonsUp;
+
+	if (m_count == 0)
+		return advanced; // Nothing newer yet, hold the last state
+
+	const Sample &next = m_samples[m_head];
+	if (next.arrival <= target)
+		return true; // Held back by a conflicting edge, played out on the next tick
+
+	const double span = Micros(next.arrival - m_base.arrival).count();
+	double alpha = span > 0.0 ? Micros(target - m_base.arrival).count() / span : 1.0;
+	alpha = std::clamp(alpha, 0.0, 1.0);
+
+	out.left_trigger = lerp(m_base.reading.left_trigger, next.reading.left_trigger, alpha);
+	out.right_trigger = lerp(m_base.reading.right_trigger, next.reading.right_trigger, alpha);
+	out.left_thumbstick_x = lerp(m_base.reading.left_thumbstick_x, next.reading.left_thumbstick_x, alpha);
+	out.left_thumbstick_y = lerp(m_base.reading.left_thumbstick_y, next.reading.left_thumbstick_y, alpha);
+	out.right_thumbstick_x =
+		lerp(m_base.reading.right_thumbstick_x, next.reading.right_thumbstick_x, alpha);
+	out.right_thumbstick_y =
+		lerp(m_base.reading.right_thumbstick_y, next.reading.right_thumbstick_y, alpha);
+	return true;
+}
+
+void PlayoutBuffer::updateDelay(Clock::time_point arrival)
+{
+	if (m_hasArrival)
+	{
+		// A client that pauses is not jittery, cap the interval so a pause does not inflate the delay
+		const double interval =
+			std::min(Micros(arrival - m_lastArrival).count(), Micros(MAX_DELAY).count());
+		if (m_meanInterval == 0.0)
+			m_meanInterval = interval;
+		m_meanInterval += (interval - m_meanInterval) * ESTIMATE_GAIN;
+		m_jitter += (std::abs(interval - m_meanInterval) - m_jitter) * ESTIMATE_GAIN;
+	}
+	m_lastArrival = arrival;
+	m_hasArrival = true;
+
+	const auto wanted =
+		std::chrono::duration_cast<Clock::duration>(Micros(m_meanInterval + JITTER_MARGIN * m_jitter));
+	m_delay = std::clamp(wanted, m_tick, MAX_DELAY);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../../VGP_Data_Exchange/C/Colfer.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Jitter buffer that turns irregular readings into a smooth, fixed-rate signal.
+ *
+ * @details
+ * Readings are played out a little after they arrived: render(now) shows the client's state
+ * as of `now - delay()`. Analog axes are interpolated between the two samples around that time,
+ * button edges are emitted once their sample is reached, in order.
+ *
+ * The delay adapts to the measured arrival jitter, like the playout buffer of a VoIP receiver:
+ * the mean interval plus a few times the mean deviation, capped at MAX_DELAY.
+ * A steady client gets about one interval of extra latency, a jittery one gets more, never above the cap.
+ *
+ * Not thread-safe, owned by the injection thread.
+ */
+class PlayoutBuffer
+{
+  public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr std::size_t CAPACITY = 64;
+
+	/**
+	 * Upper bound of the added latency.
+	 */
+	static constexpr Clock::duration MAX_DELAY = std::chrono::milliseconds(40);
+
+	/**
+	 * @param tick Interval between two render() calls, the smallest useful delay.
+	 */
+	explicit PlayoutBuffer(Clock::duration tick);
+
+	bool full() const
+	{
+		return m_count == CAPACITY;
+	}
+
+	/**
+	 * @brief Buffers a reading. When full, it is merged into the newest sample with coalesce_readings().
+	 * @param probe Latency probe of the reading (see InjectionWorker::submit()), 0 for none.
+	 * @return false if full and the reading cannot be merged without reordering edges,
+	 * render() first to make room. The reading is then not buffered.
+	 */
+	bool push(const vgp_data_exchange_gamepad_reading &reading,
+			  Clock::time_point arrival,
+			  uint32_t probe = 0);
+
+	/**
+	 * @brief Computes the reading to inject at @p now.
+	 * @param probe Set to the latest probe played out by this call, 0 for none.
+	 * @return false if there is nothing new to inject, the client's state is held.
+	 */
+	bool render(Clock::time_point now, vgp_data_exchange_gamepad_reading &out, uint32_t &probe);
+
+	Clock::duration delay() const
+	{
+		return m_delay;
+	}
+
+  private:
+	struct Sample
+	{
+		vgp_data_exchange_gamepad_reading reading;
+		Clock::time_point arrival;
+		uint32_t probe;
+	};
+
+	void updateDelay(Clock::time_point arrival);
+
+	const Clock::duration m_tick;
+	Clock::duration m_delay;
+
+	// Pending samples, oldest first, in a ring
+	std::array<Sample, CAPACITY> m_samples;
+	std::size_t m_head = 0;
+	std::size_t m_count = 0;
+
+	// Newest sample already played out, interpolation starts from it
+	Sample m_base{};
+	bool m_hasBase = false;
+
+	// Arrival jitter estimate, in microseconds
+	Clock::time_point m_lastArrival;
+	bool m_hasArrival = false;
+	double m_meanInterval = 0.0;
+	double m_jitter = 0.0;
+};
@@ -0,0 +1,52 @@
+#include "pointer_motion.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+double shape(double deflection, double curve)
+{
+	const double magnitude = std::min(std::abs(deflection), 1.0);
+	return std::copysign(curve == 1.0 ? magnitude : std::pow(magnitude, curve), deflection);
+}
+} // namespace
+
+std::pair<double, double> PointerMotion::velocity(double x, double y, double speed, double curve)
+{
+	return {shape(x, curve) * speed, shape(y, curve) * speed};
+}
+
+std::pair<int, int> PointerMotion::advance(double vx, double vy, Clock::time_point now)
+{
+	using Seconds = std::chrono::duration<double>;
+
+	// A NaN would stay in the remainders for good, and converting it to int is undefined
+	if (!std::isfinite(vx) || !std::isfinite(vy)) [[unlikely]]
+	{
+		stop();
+		return {0, 0};
+	}
+
+	Seconds elapsed = Seconds(1.0 / REFERENCE_RATE);
+	if (m_moving)
+		elapsed = std::clamp(Seconds(now - m_last), Seconds::zero(), Seconds(MAX_FRAME));
+	m_last = now;
+	m_moving = true;
+
+	const double x = m_remainderX + vx * elapsed.count();
+	const double y = m_remainderY + vy * elapsed.count();
+	// Truncated towards zero, so the remainders keep the sign of the motion
+	const double wholeX = std::trunc(x);
+	const double wholeY = std::trunc(y);
+	m_remainderX = x - wholeX;
+	m_remainderY = y - wholeY;
+	return {static_cast<int>(wholeX), static_cast<int>(wholeY)};
+}
+
+void PointerMotion::stop()
+{
+	m_moving = false;
+	m_remainderX = 0.0;
+	m_remainderY = 0.0;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <utility>
+
+/**
+ * @brief Turns stick deflection into pointer motion at a speed independent of the reading rate.
+ *
+ * @details
+ * A stick sets a velocity in pixels per second, and every advance() moves the pointer by that velocity
+ * times the time elapsed since the previous one. A client sending 30 or 250 readings per second then
+ * moves the pointer equally fast. The fractions of a pixel left over are carried to the next frame,
+ * so slow motion is not rounded away.
+ *
+ * The velocity of an axis is its deflection raised to the power of the curve, times the full speed:
+ * 1 is linear, higher values leave more precision near the center and accelerate towards the edge.
+ *
+ * Not thread-safe, owned by the executor.
+ */
+class PointerMotion
+{
+  public:
+	using Clock = std::chrono::steady_clock;
+
+	/**
+	 * Readings per second the mouse sensitivity was tuned at, when the pointer moved by it per reading.
+	 * Full deflection moves sensitivity times this many pixels per second.
+	 */
+	static constexpr double REFERENCE_RATE = 60.0;
+
+	/**
+	 * Longest time one frame accounts for, so the pointer does not jump after a pause in the readings.
+	 */
+	static constexpr Clock::duration MAX_FRAME = std::chrono::milliseconds(50);
+
+	/**
+	 * @brief Velocity of a stick in pixels per second.
+	 * @param x,y Deflection of the stick, in [-1, 1].
+	 * @param speed Pixels per second at full deflection.
+	 * @param curve Exponent of the acceleration curve, 1 for linear.
+	 */
+	static std::pair<double, double> velocity(double x, double y, double speed, double curve);
+
+	/**
+	 * @brief Whole pixels to move by at @p now, at velocity @p vx, @p vy.
+	 *
+	 * The first frame after stop() accounts for one reading at REFERENCE_RATE.
+	 * A velocity that is not finite (a NaN from a corrupt reading) stops the motion instead.
+	 */
+	std::pair<int, int> advance(double vx, double vy, Clock::time_point now);
+
+	/**
+	 * @brief Stops the motion, dropping the fractions left over.
+	 */
+	void stop();
+
+  private:
+	Clock::time_point m_last;
+	bool m_moving = false;
+	double m_remainderX = 0.0;
+	double m_remainderY = 0.0;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+/**
+ * @brief Fixed-capacity receive buffer for a stream socket.
+ *
+ * @details
+ * The socket reads straight into writePtr() and the parser reads straight from data(),
+ * consume() only advances a cursor. Leftover bytes of an incomplete reading are moved
+ * to the front by compact(), once per wakeup instead of once per reading.
+ *
+ * The capacity never changes, so a client sending garbage cannot grow it.
+ * A gamepad reading is a few dozen bytes, anything that does not fit is not a reading.
+ */
+template <std::size_t Capacity> class ReceiveBuffer
+{
+  public:
+	const char *data() const
+	{
+		return m_storage.data() + m_begin;
+	}
+
+	std::size_t size() const
+	{
+		return m_end - m_begin;
+	}
+
+	bool empty() const
+	{
+		return m_begin == m_end;
+	}
+
+	char *writePtr()
+	{
+		return m_storage.data() + m_end;
+	}
+
+	std::size_t writable() const
+	{
+		return Capacity - m_end;
+	}
+
+	/**
+	 * @brief Marks @p len bytes written at writePtr() as received.
+	 */
+	void commit(std::size_t len)
+	{
+		m_end += len;
+	}
+
+	/**
+	 * @brief Marks @p len bytes at data() as parsed.
+	 */
+	void consume(std::size_t len)
+	{
+		m_begin += len;
+		if (m_begin == m_end)
+			m_begin = m_end = 0; // Cheap reset, the common case of a fully parsed burst
+	}
+
+	/**
+	 * @brief Moves the unparsed bytes to the front, making all free space writable.
+	 */
+	void compact()
+	{
+		if (m_begin == 0)
+			return;
+		std::memmove(m_storage.data(), m_storage.data() + m_begin, size());
+		m_end -= m_begin;
+		m_begin = 0;
+	}
+
+	void clear()
+	{
+		m_begin = m_end = 0;
+	}
+
+	static constexpr std::size_t capacity()
+	{
+		return Capacity;
+	}
+
+  private:
+	std::array<char, Capacity> m_storage;
+	std::size_t m_begin = 0;
+	std::size_t m_end = 0;
+};
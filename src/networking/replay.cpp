@@ -0,0 +1,215 @@
+#include "replay.hpp"
+#include "compact_frame.hpp"
+#include "time_sync.hpp"
+
+#include <QDebug>
+#include <algorithm>
+#include <chrono>
+#include <span>
+#include <thread>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+uint64_t elapsedNanoseconds(Clock::time_point since)
+{
+	return static_cast<uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count());
+}
+} // namespace
+
+CaptureReplayer::CaptureReplayer(ExecutorFactory createExecutor, Timing timing)
+	: m_createExecutor(std::move(createExecutor)), m_timing(timing)
+{
+}
+
+void CaptureReplayer::run(CaptureReader &reader)
+{
+	const Clock::time_point start = Clock::now();
+	capture::Record record;
+	while (reader.next(record))
+	{
+		if (m_timing == Timing::Original)
+			std::this_thread::sleep_until(start + record.time);
+
+		m_recordCount++;
+		Session &target = session(record.session);
+		switch (record.kind)
+		{
+		case capture::RecordKind::Stream:
+			replayStream(target, record.data, record.length);
+			break;
+		case capture::RecordKind::Datagram:
+			replayDatagram(target, record.data, record.length);
+			break;
+		case capture::RecordKind::Frames:
+			replayFrames(target, record.data, record.length);
+			break;
+		default:
+			qWarning() << "Skipping capture record of unknown kind" << static_cast<int>(record.kind);
+			break;
+		}
+	}
+}
+
+CaptureReplayer::Session &CaptureReplayer::session(uint64_t id)
+{
+	auto it = m_sessions.find(id);
+	if (it == m_sessions.end())
+	{
+		auto created = std::make_unique<Session>();
+		created->executor = m_createExecutor();
+		it = m_sessions.emplace(id, std::move(created)).first;
+	}
+	return *it->second;
+}
+
+void CaptureReplayer::replayStream(Session &session, const char *data, std::size_t length)
+{
+	// Same framing as ClientSession::readStream(), a record may hold several readings or part of one
+	while (length > 0)
+	{
+		if (session.buffer.writable() == 0)
+		{
+			m_parseErrors++;
+			session.buffer.clear();
+		}
+		const std::size_t chunk = std::min(length, session.buffer.writable());
+		std::copy_n(data, chunk, session.buffer.writePtr());
+		session.buffer.commit(chunk);
+		data += chunk;
+		length -= chunk;
+
+		while (!session.buffer.empty())
+		{
+			const auto first = static_cast<uint8_t>(session.buffer.data()[0]);
+			if (first == time_sync::CONTROL_BYTE)
+			{
+				std::size_t consumed = 0;
+				handleControl(session, session.buffer.data(), session.buffer.size(), consumed);
+				if (consumed == 0)
+					break; // Incomplete
+				session.buffer.consume(consumed);
+				continue;
+			}
+			if (first == compact_frame::MARKER)
+			{
+				if (session.buffer.size() < compact_frame::FRAME_SIZE)
+					break;
+				if (!replayCompact(session, session.buffer.data()))
+				{
+					m_parseErrors++;
+					session.buffer.clear();
+					break;
+				}
+				session.buffer.consume(compact_frame::FRAME_SIZE);
+				continue;
+			}
+
+			const Clock::time_point parseStart = Clock::now();
+			const BatchParseResult batch = parse_gamepad_states(
+				std::as_bytes(std::span(session.buffer.data(), session.buffer.size())), m_batch);
+			if (batch.count > 0)
+				m_parseTime.record(elapsedNanoseconds(parseStart) / batch.count);
+			for (std::size_t i = 0; i < batch.count; i++)
+				inject(session, m_batch[i]);
+			session.buffer.consume(batch.bytes_consumed);
+
+			using enum BatchParseResult::Stop;
+			if (batch.stop == IncompleteData)
+				break;
+			if (batch.stop == SchemaMismatch || batch.stop == DataTooLarge)
+			{
+				m_parseErrors++;
+				session.buffer.clear();
+				break;
+			}
+		}
+		session.buffer.compact();
+	}
+}
+
+void CaptureReplayer::replayDatagram(Session &session, const char *data, std::size_t length)
+{
+	if (length > 0 && static_cast<uint8_t>(data[0]) == time_sync::CONTROL_BYTE)
+	{
+		std::size_t consumed = 0;
+		handleControl(session, data, length, consumed);
+		return;
+	}
+	if (length == compact_frame::FRAME_SIZE && static_cast<uint8_t>(data[0]) == compact_frame::MARKER)
+	{
+		if (!replayCompact(session, data))
+			m_parseErrors++;
+		return;
+	}
+
+	const Clock::time_point parseStart = Clock::now();
+	udp_frame::Frame frame;
+	const bool decoded = udp_frame::decode(reinterpret_cast<const uint8_t *>(data), length, frame);
+	m_parseTime.record(elapsedNanoseconds(parseStart));
+	if (!decoded)
+	{
+		m_parseErrors++;
+		return;
+	}
+	if (session.sequencer.accept(frame))
+		inject(session, frame.reading);
+}
+
+void CaptureReplayer::replayFrames(Session &session, const char *data, std::size_t length)
+{
+	// Same as ClientSession::receiveFrames(), the shared-memory transport needs no hello
+	if (length % compact_frame::FRAME_SIZE != 0)
+		m_parseErrors++;
+	const std::size_t count = length / compact_frame::FRAME_SIZE;
+	for (std::size_t i = 0; i < count; i++)
+	{
+		if (!deliverCompact(session, data + i * compact_frame::FRAME_SIZE))
+			m_parseErrors++;
+	}
+}
+
+void CaptureReplayer::handleControl(Session &session,
+									const char *data,
+									std::size_t length,
+									std::size_t &consumed)
+{
+	// Only the outcome of the handshake matters, the answers went to the client live
+	time_sync::Message message;
+	if (time_sync::decode(data, length, message, consumed) == time_sync::DecodeResult::Ok &&
+		message.kind == time_sync::Message::Kind::Hello)
+	{
+		session.compactFrames = (message.capabilities & time_sync::CAPABILITY_COMPACT_FRAMES) != 0;
+	}
+}
+
+bool CaptureReplayer::replayCompact(Session &session, const char *data)
+{
+	return session.compactFrames && deliverCompact(session, data);
+}
+
+bool CaptureReplayer::deliverCompact(Session &session, const char *data)
+{
+	const Clock::time_point parseStart = Clock::now();
+	udp_frame::Frame frame;
+	const bool decoded = compact_frame::decode(reinterpret_cast<const uint8_t *>(data), frame);
+	m_parseTime.record(elapsedNanoseconds(parseStart));
+	if (!decoded)
+		return false;
+
+	frame.sequence = compact_frame::extendSequence(static_cast<uint16_t>(frame.sequence),
+												   session.sequencer.lastSequence());
+	if (session.sequencer.accept(frame))
+		inject(session, frame.reading);
+	return true;
+}
+
+void CaptureReplayer::inject(Session &session, const vgp_data_exchange_gamepad_reading &reading)
+{
+	m_readingCount++;
+	const Clock::time_point injectStart = Clock::now();
+	session.executor->inject_gamepad_state(reading);
+	m_injectTime.record(elapsedNanoseconds(injectStart));
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "capture.hpp"
+#include "executor.hpp"
+#include "histogram.hpp"
+#include "receive_buffer.hpp"
+#include "udp_frame.hpp"
+
+#include <array>
+#include <functional>
+#include <map>
+#include <memory>
+
+/**
+ * @brief Feeds a capture file back through the parser and an executor.
+ *
+ * @details
+ * Every session of the capture gets its own executor, like it did live. Readings are parsed and
+ * injected on the calling thread, one after the other: the injection queue, coalescing and the
+ * jitter buffer depend on thread timing and are left out, so two replays of a capture make exactly
+ * the same executor calls. Time sync control frames are skipped, there is no client to answer,
+ * except for the hello that lets a session send compact frames. Frames of the shared-memory
+ * transport need no hello, like live.
+ *
+ * With Timing::Original, every record is replayed at its capture time relative to the start of
+ * the replay. With Timing::Fast they are replayed back to back, to profile the parser and executor.
+ */
+class CaptureReplayer
+{
+  public:
+	enum class Timing
+	{
+		Original,
+		Fast
+	};
+
+	using ExecutorFactory = std::function<std::unique_ptr<ExecutorInterface>()>;
+
+	CaptureReplayer(ExecutorFactory createExecutor, Timing timing);
+
+	/**
+	 * @brief Replays every record of @p reader, from its current position.
+	 * @throws std::exception if an executor cannot be created.
+	 */
+	void run(CaptureReader &reader);
+
+	uint64_t recordCount() const
+	{
+		return m_recordCount;
+	}
+
+	uint64_t readingCount() const
+	{
+		return m_readingCount;
+	}
+
+	uint64_t parseErrors() const
+	{
+		return m_parseErrors;
+	}
+
+	std::size_t sessionCount() const
+	{
+		return m_sessions.size();
+	}
+
+	/**
+	 * Nanoseconds spent decoding one reading, averaged per batch like the server does.
+	 */
+	const Histogram &parseTime() const
+	{
+		return m_parseTime;
+	}
+
+	/**
+	 * Nanoseconds spent in the executor for one reading.
+	 */
+	const Histogram &injectTime() const
+	{
+		return m_injectTime;
+	}
+
+  private:
+	struct Session
+	{
+		std::unique_ptr<ExecutorInterface> executor;
+		ReceiveBuffer<4096> buffer;
+		UdpSequencer sequencer;
+		bool compactFrames = false;
+	};
+
+	Session &session(uint64_t id);
+	void replayStream(Session &session, const char *data, std::size_t length);
+	void replayDatagram(Session &session, const char *data, std::size_t length);
+	void replayFrames(Session &session, const char *data, std::size_t length);
+	void handleControl(Session &session, const char *data, std::size_t length, std::size_t &consumed);
+	bool replayCompact(Session &session, const char *data);
+	bool deliverCompact(Session &session, const char *data);
+	void inject(Session &session, const vgp_data_exchange_gamepad_reading &reading);
+
+	ExecutorFactory m_createExecutor;
+	Timing m_timing;
+	std::map<uint64_t, std::unique_ptr<Session>> m_sessions;
+	std::array<vgp_data_exchange_gamepad_reading, 64> m_batch; // Output of the parser
+
+	uint64_t m_recordCount = 0;
+	uint64_t m_readingCount = 0;
+	uint64_t m_parseErrors = 0;
+	Histogram m_parseTime;
+	Histogram m_injectTime;
+};
@@ -10,7 +10,7 @@
 #include <QList>
 #include <QMessageBox>
 #include <QNetworkInterface>
-#include <QThread>
+#include <QStringList>
 
 /**
  * @brief Creates a QR code from a string
@@ -45,6 +45,20 @@ QImage createQR(const QString &data, const int border = 1, const uint scalingFac
 	return image.scaled(image.size() * scalingFactor);
 }
 
+/**
+ * @brief Formats the percentiles of a histogram as "p50/p99/p99.9/max".
+ * @param scale Divides the recorded values, e.g. 1000 to show nanoseconds as microseconds
+ */
+QString formatPercentiles(const HistogramSummary &summary, double scale)
+{
+	auto format = [scale](uint64_t value)
+	{
+		return QString::number(static_cast<double>(value) / scale, 'f', scale > 1.0 ? 2 : 0);
+	};
+	return QString("%1/%2/%3/%4")
+		.arg(format(summary.p50), format(summary.p99), format(summary.p999), format(summary.max));
+}
+
 Server::Server(QWidget *parent) : QWidget(parent), ui(new Ui::Server)
 {
 	qInfo() << "Initializing TCP server";
@@ -53,24 +67,10 @@ Server::Server(QWidget *parent) : QWidget(parent), ui(new Ui::Server)
 	ui->IPList->viewport()->setAutoFillBackground(false);
 	// delete this when stop button is clicked
 	connect(ui->stopButton, &QPushButton::clicked, this, &Server::destroyServer);
-	clientConnection = nullptr;
-	tcpServer = new QTcpServer(this);
-	isGamepadConnected = false;
 
-	// Initialize the executor with try-catch for better error handling
-	switch (SettingsSingleton::instance().executorType())
-	{
-	case ExecutorType::GamepadExecutor:
-		executor = std::make_unique<GamepadExecutor>();
-		qInfo() << "GamepadExecutor initialized successfully";
-		break;
-	case ExecutorType::KeyboardMouseExecutor:
-		executor = std::make_unique<KeyboardMouseExecutor>();
-		qInfo() << "KeyboardMouseExecutor initialized successfully";
-		break;
-	default:
-		qCritical() << "Unknown executor type";
-	}
+	networkWorker = new NetworkWorker();
+	networkWorker->moveToThread(&networkThread);
+	networkThread.setObjectName("VGP network");
 
 	initServer();
 
@@ -79,38 +79,44 @@ Server::Server(QWidget *parent) : QWidget(parent), ui(new Ui::Server)
 
 Server::~Server()
 {
-	// IMPORTANT: clientConnection should not be accessed when the server is closed
-	if (isGamepadConnected && clientConnection != nullptr)
+	// Closes every session, which joins their injection threads
+	if (networkThread.isRunning())
 	{
-		clientConnection->close(); // Close clientConnection gracefully
-		clientConnection = nullptr;
-		isGamepadConnected = false;
+		QMetaObject::invokeMethod(networkWorker, &NetworkWorker::stop, Qt::BlockingQueuedConnection);
+		networkThread.quit();
+		networkThread.wait();
 	}
-	tcpServer->close(); // And then close the server
+	delete networkWorker;
 	qInfo() << "Server stopped.";
-	tcpServer->deleteLater();
 	delete ui;
 }
 
 void Server::initServer()
 {
-	qInfo() << "Starting TCP server initialization";
-
-	tcpServer->setListenBacklogSize(0);
-	auto port = SettingsSingleton::instance().port();
+	connect(networkWorker, &NetworkWorker::listening, this, &Server::showServerInfo);
+	connect(networkWorker, &NetworkWorker::listenFailed, this, &Server::showListenError);
+	connect(networkWorker, &NetworkWorker::statsUpdated, this, &Server::showStats);
+	connect(networkWorker, &NetworkWorker::clientConnected, this, &Server::addClient);
+	connect(networkWorker, &NetworkWorker::clientDisconnected, this, &Server::removeClient);
+	connect(networkWorker, &NetworkWorker::sessionFailed, this, &Server::showSessionError);
+
+	networkThread.start();
+
+	QMetaObject::invokeMethod(
+		networkWorker,
+		[worker = networkWorker, config = ServerConfig::fromSettings()]()
+		{
+			worker->startListening(config);
+		},
+		Qt::QueuedConnection);
+}
 
-	if (!tcpServer->listen(QHostAddress::AnyIPv4, port))
-	{
-		QMessageBox::critical(this,
-							  tr("VGamepad Server"),
-							  tr("Unable to start the server: %1.").arg(tcpServer->errorString()));
-		close(); // Close the error dialog
-		tcpServer->close();
-		return;
-	}
+void Server::showServerInfo(quint16 port)
+{
 	QString message = tr("**Warning:** The server will stop if you close this window.\n\n");
-	message += tr("The server is running on\n\nPort: `%1`\n\nAt the following IP Address(es):\n\n")
-				   .arg(tcpServer->serverPort());
+	message += tr("The server is running on\n\nPort: `%1` (%2)\n\nAt the following IP Address(es):\n\n")
+				   .arg(port)
+				   .arg(SettingsSingleton::instance().transport() == TransportMode::Udp ? "UDP" : "TCP");
 	const QList<QHostAddress> ipAddressesList = QNetworkInterface::allAddresses();
 	for (const QHostAddress &entry : ipAddressesList)
 	{
@@ -118,8 +124,8 @@ void Server::initServer()
 		{
 			ui->IPList->addItem(tr("%1").arg(entry.toString()));
 			QLabel *QRWidget = new QLabel();
-			QRWidget->setPixmap(QPixmap::fromImage(
-				createQR(tr("%1:%2").arg(entry.toString()).arg(tcpServer->serverPort()))));
+			QRWidget->setPixmap(
+				QPixmap::fromImage(createQR(tr("%1:%2").arg(entry.toString()).arg(port))));
 			ui->QRViewer->addWidget(QRWidget);
 		}
 	}
@@ -141,108 +147,88 @@ void Server::initServer()
 					ui->QRViewer->setCurrentIndex(ui->IPList->row(current));
 				}
 			});
-	connect(tcpServer, &QTcpServer::newConnection, this, &Server::handleConnection);
-	qInfo() << "Server started successfully on port:" << tcpServer->serverPort();
 }
 
-void Server::handleConnection()
+void Server::showListenError(const QString &error)
 {
-	clientConnection = tcpServer->nextPendingConnection();
-	// disable Nagle's algorithm to avoid delay and bunching of small packages
-	clientConnection->setSocketOption(QAbstractSocket::LowDelayOption, 1);
-	isGamepadConnected = true;
-	QString connectionMessage;
-	connectionMessage =
-		tr("Connected to %1 at `%2 : %3`")
-			.arg(clientConnection->peerName().isEmpty() ? "Unknown device" : clientConnection->peerName(),
-				 clientConnection->peerAddress().toString(),
-				 QString::number(clientConnection->peerPort()));
-	qInfo().noquote() << connectionMessage;
-	ui->clientLabel->setText(connectionMessage);
-	tcpServer->pauseAccepting();
-	connect(clientConnection, &QAbstractSocket::disconnected, clientConnection, &QObject::deleteLater);
-	connect(clientConnection,
-			&QAbstractSocket::disconnected,
-			this,
-			[this]()
-			{
-				ui->clientLabel->setText(tr("No device connected"));
-				qInfo() << "Device disconnected.";
-				qDebug() << "Average Request Interval" << averageRequestInterval
-						 << "ms, Request Count:" << requestCount;
-				isGamepadConnected = false;
-				tcpServer->resumeAccepting();
-			});
-	connect(clientConnection, &QAbstractSocket::readyRead, this, &Server::serveClient);
-
-	qInfo() << "New client connection received";
+	QMessageBox::critical(this, tr("VGamepad Server"), tr("Unable to start the server: %1.").arg(error));
+	close(); // Close the error dialog
 }
 
-void Server::serveClient()
+void Server::showSessionError(const QString &error)
 {
-#ifdef QT_DEBUG
-	qDebug() << "Received: " << clientConnection->bytesAvailable() << "bytes";
-#endif
+	// The server keeps running, only this client was turned away
+	QMessageBox::warning(this, tr("VGamepad Server"), tr("Unable to serve a new device: %1.").arg(error));
+}
 
-	// Append new data to our buffer
-	dataBuffer.append(clientConnection->readAll());
+void Server::addClient(quint64 sessionId, const QString &description)
+{
+	clients[sessionId].description = description;
+	refreshClients();
+}
 
-#ifdef QT_DEBUG
-	qDebug() << "Buffer contents: " << dataBuffer;
-#endif
+void Server::removeClient(quint64 sessionId)
+{
+	clients.erase(sessionId);
+	refreshClients();
+}
 
-	QTime currentTime = QTime::currentTime();
+void Server::showStats(quint64 sessionId, const SessionStats &stats)
+{
+	auto it = clients.find(sessionId);
+	if (it == clients.end())
+		return; // Final snapshot of a session that is already gone
+	it->second.stats = stats;
+	refreshClients();
+}
 
-	// Process as many complete packets as we have in the buffer
-	while (!dataBuffer.isEmpty())
+void Server::refreshClients()
+{
+	if (clients.empty())
 	{
-		ParseResult result = parse_gamepad_state(dataBuffer.constData(), dataBuffer.size());
-
-		if (!result.success)
-		{
-			switch (result.failure_reason)
-			{
-				using enum ParseResult::FailureReason;
-			[[likely]] case IncompleteData:
-				// Wait for more data
-				break;
-			case SchemaMismatch:
-				qWarning() << "Schema mismatch detected in client data";
-				dataBuffer.remove(0, result.bytes_consumed); // Remove the processed data
-				break;
-			case DataTooLarge:
-				qWarning() << "Client sent data that is too large to process";
-				dataBuffer.remove(0, result.bytes_consumed); // Remove the processed data
-				break;
-			[[unlikely]] default:
-				qWarning() << "Unknown error occurred while parsing client data";
-				dataBuffer.clear(); // Clear buffer to avoid cascading errors
-				break;
-			}
-			break; // Exit the processing loop
-		}
+		ui->clientLabel->setText(tr("No device connected"));
+		ui->statsLabel->clear();
+		return;
+	}
 
-		// Process the gamepad reading
-		requestCount++;
-		// Calculate performance metrics
-		if (lastRequestTime.isValid())
+	const bool udp = SettingsSingleton::instance().transport() == TransportMode::Udp;
+	const bool ticked = SettingsSingleton::instance().injectionRate() > 0;
+	QStringList descriptions;
+	QStringList statLines;
+	for (const auto &[id, client] : clients)
+	{
+		descriptions << client.description;
+		QString line =
+			tr("#%1 · Readings: %2 · Avg interval: %3 ms · Injected: %4 · Collapsed: %5 · Queued: %6 · "
+			   "Dropped: %7")
+				.arg(id)
+				.arg(client.stats.requestCount)
+				.arg(client.stats.averageRequestInterval, 0, 'f', 1)
+				.arg(client.stats.injectedCount)
+				.arg(client.stats.collapsedCount)
+				.arg(client.stats.queueDepth)
+				.arg(client.stats.droppedCount);
+		if (udp)
+			line += tr(" · Lost: %1 · Stale: %2").arg(client.stats.lostCount).arg(client.stats.staleCount);
+		if (ticked)
+			line += tr(" · Playout delay: %1 ms").arg(client.stats.playoutDelay, 0, 'f', 1);
+		// p50/p99/p99.9/max, the tail is what a player notices
+		line += tr("\n    Interval: %1 ms · Parse: %2 µs · Inject: %3 µs · Queue depth: %4")
+					.arg(formatPercentiles(client.stats.interArrivalTime, 1e6),
+						 formatPercentiles(client.stats.parseTime, 1e3),
+						 formatPercentiles(client.stats.injectTime, 1e3),
+						 formatPercentiles(client.stats.queueDepthPercentiles, 1.0));
+		if (client.stats.endToEndLatency.count > 0)
 		{
-			int elapsed = lastRequestTime.msecsTo(currentTime);
-			// Update average request interval, using running average
-			averageRequestInterval += (elapsed - averageRequestInterval) / requestCount;
+			line += tr("\n    Touch to injection: %1 ms · Clock offset: %2 ms · Round trip: %3 ms")
+						.arg(formatPercentiles(client.stats.endToEndLatency, 1e6))
+						.arg(client.stats.clockOffset, 0, 'f', 2)
+						.arg(client.stats.roundTrip, 0, 'f', 2);
 		}
-		lastRequestTime = currentTime;
-
-		executor->inject_gamepad_state(result.reading);
-
-		// Remove the processed data from the buffer
-		dataBuffer.remove(0, result.bytes_consumed);
-
-#ifdef QT_DEBUG
-		qDebug() << "Consumed" << result.bytes_consumed
-				 << "bytes, remaining buffer size:" << dataBuffer.size();
-#endif
+		statLines << line;
 	}
+	ui->clientLabel->setText(descriptions.join('\n'));
+	ui->statsLabel->setText(statLines.join('\n'));
 }
 
 void Server::destroyServer()
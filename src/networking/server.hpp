@@ -1,19 +1,26 @@
 #pragma once
 
-#include "executor.hpp"
+#include "network_worker.hpp"
+#include "session_stats.hpp"
 
-#include <QByteArray>
-#include <QDialog>
-#include <QTcpServer>
-#include <QTcpSocket>
-#include <QTime>
-#include <memory>
+#include <QString>
+#include <QThread>
+#include <QWidget>
+#include <map>
 
 namespace Ui
 {
 class Server;
 }
 
+/**
+ * @brief The server screen.
+ *
+ * @details
+ * Only presentation lives here. Receiving and parsing run in a NetworkWorker on a dedicated
+ * network thread, injection runs on one thread per connected client.
+ * This widget just reacts to their signals, so repaints and modal dialogs never delay input.
+ */
 class Server : public QWidget
 {
 	Q_OBJECT
@@ -24,22 +31,28 @@ class Server : public QWidget
   public:
 	explicit Server(QWidget *parent = nullptr);
 	~Server() override;
-	QTcpServer *tcpServer = nullptr;
 
   private slots:
-	void handleConnection();
 	void destroyServer();
+	void showServerInfo(quint16 port);
+	void showListenError(const QString &error);
+	void addClient(quint64 sessionId, const QString &description);
+	void removeClient(quint64 sessionId);
+	void showSessionError(const QString &error);
+	void showStats(quint64 sessionId, const SessionStats &stats);
 
   private:
+	struct ClientInfo
+	{
+		QString description;
+		SessionStats stats;
+	};
+
 	void initServer();
-	void serveClient();
+	void refreshClients();
 
 	Ui::Server *ui;
-	QTcpSocket *clientConnection;
-	bool isGamepadConnected;
-	QTime lastRequestTime;
-	double averageRequestInterval = 0.0;
-	uint_fast32_t requestCount = 0;
-	QByteArray dataBuffer; // Buffer to store incoming data
-	std::unique_ptr<ExecutorInterface> executor = nullptr;
+	QThread networkThread;
+	NetworkWorker *networkWorker = nullptr;
+	std::map<quint64, ClientInfo> clients; // Connected clients, by session id
 };
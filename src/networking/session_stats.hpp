@@ -0,0 +1,45 @@
+#pragma once
+
+#include "histogram.hpp"
+
+#include <QMetaType>
+#include <cstdint>
+
+/**
+ * @brief A point-in-time copy of the counters of a client session.
+ *
+ * @details
+ * The receive and injection threads own the live counters and histograms.
+ * This snapshot is what gets handed to the GUI thread, so the widgets never touch the hot path.
+ */
+struct SessionStats
+{
+	uint64_t requestCount = 0;			 // Gamepad readings parsed from the client
+	double averageRequestInterval = 0.0; // Running average of the time between readings (ms)
+	uint64_t bytesReceived = 0;			 // Raw bytes read from the socket
+	uint64_t parseErrors = 0;			 // Schema mismatches and oversized frames
+	uint64_t injectedCount = 0;			 // Readings handed to the executor
+	uint64_t droppedCount = 0;			 // Readings merged into their final state, the queue overflowing
+	uint64_t collapsedCount = 0;		 // Readings merged into a later one by the injection thread
+	uint64_t queueDepth = 0;			 // Readings waiting in the injection queue
+	uint64_t staleCount = 0;			 // UDP datagrams dropped as out-of-order or duplicate
+	uint64_t lostCount = 0;				 // UDP datagrams missing from the sequence
+	double playoutDelay = 0.0;			 // Jitter buffer delay of the fixed-rate injection (ms)
+	bool compactFrames = false;			 // The client negotiated compact frames, see compact_frame.hpp
+	bool heartbeat = false;				 // The client negotiated heartbeats, see time_sync.hpp
+	uint64_t stallCount = 0;			 // Times the client went silent holding inputs, which were released
+
+	// Distributions since the session started, an average hides the spikes a player notices
+	HistogramSummary interArrivalTime;		// Between two readings (ns)
+	HistogramSummary parseTime;				// Decoding one reading (ns)
+	HistogramSummary injectTime;			// One executor call (ns)
+	HistogramSummary queueDepthPercentiles; // Readings in the injection queue after each submit
+	HistogramSummary stallDuration;			// From the release of a stalled session to its next byte (ns)
+
+	// Only if the client sends time_sync pings
+	HistogramSummary endToEndLatency; // From the touch on the client to the injection (ns)
+	double clockOffset = 0.0;		  // Server clock minus client clock (ms)
+	double roundTrip = 0.0;			  // Network round trip of the best clock exchange (ms)
+};
+
+Q_DECLARE_METATYPE(SessionStats)
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+/**
+ * @brief Bounded lock-free single-producer/single-consumer queue.
+ *
+ * @details
+ * Exactly one thread may call try_push() and exactly one (other) thread may call try_pop().
+ * The head and tail indices live on separate cache lines so the producer and the consumer
+ * never write to the same line. Each side also caches the last observed index of the other
+ * side, so the shared atomics are only read when the queue looks full (producer) or empty
+ * (consumer).
+ *
+ * @tparam T Trivially copyable element type
+ * @tparam Capacity Number of slots, must be a power of two
+ */
+template <typename T, std::size_t Capacity>
+class SpscQueue
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+  public:
+	SpscQueue() = default;
+
+	// Delete copy and move operations, the indices are shared between threads
+	SpscQueue(const SpscQueue &) = delete;
+	SpscQueue &operator=(const SpscQueue &) = delete;
+	SpscQueue(SpscQueue &&) = delete;
+	SpscQueue &operator=(SpscQueue &&) = delete;
+
+	/**
+	 * @brief Enqueue an item (producer thread only).
+	 *
+	 * @return false if the queue is full, the item is not enqueued.
+	 */
+	bool try_push(const T &item) noexcept
+	{
+		const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_cachedHead == Capacity)
+		{
+			m_cachedHead = m_head.load(std::memory_order_acquire);
+			if (tail - m_cachedHead == Capacity)
+				return false;
+		}
+		m_slots[tail & Mask] = item;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Dequeue an item (consumer thread only).
+	 *
+	 * @return false if the queue is empty, item is left untouched.
+	 */
+	bool try_pop(T &item) noexcept
+	{
+		const std::size_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_cachedTail)
+		{
+			m_cachedTail = m_tail.load(std::memory_order_acquire);
+			if (head == m_cachedTail)
+				return false;
+		}
+		item = m_slots[head & Mask];
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Number of queued items. Exact only when called from one of the two owning threads
+	 * while the other one is idle, otherwise a snapshot.
+	 */
+	std::size_t size() const noexcept
+	{
+		return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+	}
+
+	bool empty() const noexcept
+	{
+		return size() == 0;
+	}
+
+	static constexpr std::size_t capacity() noexcept
+	{
+		return Capacity;
+	}
+
+  private:
+	static constexpr std::size_t Mask = Capacity - 1;
+	static constexpr std::size_t CacheLine = 64;
+
+	// Consumer side
+	alignas(CacheLine) std::atomic<std::size_t> m_head{0};
+	std::size_t m_cachedTail = 0;
+
+	// Producer side
+	alignas(CacheLine) std::atomic<std::size_t> m_tail{0};
+	std::size_t m_cachedHead = 0;
+
+	alignas(CacheLine) std::array<T, Capacity> m_slots{};
+};
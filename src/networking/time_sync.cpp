@@ -0,0 +1,192 @@
+#include "time_sync.hpp"
+
+#include <QList>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+
+namespace
+{
+bool parseText(const QByteArray &text, time_sync::Message &message)
+{
+	using Kind = time_sync::Message::Kind;
+
+	const QList<QByteArray> fields = text.split(' ');
+	if (fields.isEmpty())
+		return false;
+
+	std::size_t expected;
+	if (fields[0] == "ping")
+	{
+		message.kind = Kind::Ping;
+		expected = 3;
+	}
+	else if (fields[0] == "pong")
+	{
+		message.kind = Kind::Pong;
+		expected = 6;
+	}
+	else if (fields[0] == "done")
+	{
+		message.kind = Kind::Done;
+		expected = 3;
+	}
+	else if (fields[0] == "hello")
+	{
+		message.kind = Kind::Hello;
+		expected = 3;
+	}
+	else if (fields[0] == "welcome")
+	{
+		message.kind = Kind::Welcome;
+		expected = 3;
+	}
+	else
+	{
+		return false;
+	}
+	if (static_cast<std::size_t>(fields.size()) != expected)
+		return false;
+
+	bool ok = true;
+	auto number = [&ok, &fields](qsizetype index)
+	{
+		bool parsed = false;
+		const qlonglong value = fields[index].toLongLong(&parsed);
+		ok = ok && parsed;
+		return static_cast<int64_t>(value);
+	};
+
+	switch (message.kind)
+	{
+	case Kind::Ping:
+		message.seq = static_cast<uint32_t>(number(1));
+		message.t1 = number(2);
+		break;
+	case Kind::Pong:
+		message.seq = static_cast<uint32_t>(number(1));
+		message.t1 = number(2);
+		message.t2 = number(3);
+		message.ti = number(4);
+		message.t3 = number(5);
+		break;
+	case Kind::Done:
+		message.seq = static_cast<uint32_t>(number(1));
+		message.t4 = number(2);
+		break;
+	case Kind::Hello:
+	case Kind::Welcome:
+		message.version = static_cast<uint32_t>(number(1));
+		message.capabilities = static_cast<uint32_t>(number(2));
+		break;
+	}
+	return ok;
+}
+} // namespace
+
+time_sync::DecodeResult time_sync::decode(const char *data,
+										   std::size_t len,
+										   Message &message,
+										   std::size_t &consumed)
+{
+	consumed = 0;
+	if (len == 0)
+		return DecodeResult::Incomplete;
+	if (static_cast<uint8_t>(data[0]) != CONTROL_BYTE)
+		return DecodeResult::Invalid;
+
+	// Never look further than MAX_CONTROL_SIZE, whatever length the frame claims
+	const std::size_t available = std::min(len, MAX_CONTROL_SIZE) - 1;
+	vgp_data_exchange_message decoded{};
+	const std::size_t octets = vgp_data_exchange_message_unmarshal(&decoded, data + 1, available);
+	if (octets == 0)
+	{
+		if (errno == EWOULDBLOCK && len < MAX_CONTROL_SIZE)
+			return DecodeResult::Incomplete;
+		// Too long or not a message, there is no way to tell where it ends
+		consumed = len;
+		return DecodeResult::Invalid;
+	}
+	consumed = 1 + octets;
+
+	// Colfer allocates text fields with malloc
+	const QByteArray text(decoded.contents.utf8, static_cast<qsizetype>(decoded.contents.len));
+	std::free(const_cast<char *>(decoded.contents.utf8));
+
+	return parseText(text, message) ? DecodeResult::Ok : DecodeResult::Invalid;
+}
+
+QByteArray time_sync::encode(const Message &message)
+{
+	using Kind = Message::Kind;
+	auto number = [](int64_t value)
+	{
+		return QByteArray::number(static_cast<qlonglong>(value));
+	};
+
+	QList<QByteArray> fields;
+	switch (message.kind)
+	{
+	case Kind::Ping:
+		fields = {"ping", number(message.seq), number(message.t1)};
+		break;
+	case Kind::Pong:
+		fields = {"pong",
+				  number(message.seq),
+				  number(message.t1),
+				  number(message.t2),
+				  number(message.ti),
+				  number(message.t3)};
+		break;
+	case Kind::Done:
+		fields = {"done", number(message.seq), number(message.t4)};
+		break;
+	case Kind::Hello:
+		fields = {"hello", number(message.version), number(message.capabilities)};
+		break;
+	case Kind::Welcome:
+		fields = {"welcome", number(message.version), number(message.capabilities)};
+		break;
+	}
+	const QByteArray text = fields.join(' ');
+
+	vgp_data_exchange_message encoded{};
+	encoded.contents.utf8 = text.constData();
+	encoded.contents.len = static_cast<std::size_t>(text.size());
+
+	QByteArray frame(static_cast<qsizetype>(1 + vgp_data_exchange_message_marshal_len(&encoded)), '\0');
+	frame[0] = static_cast<char>(CONTROL_BYTE);
+	const std::size_t octets = vgp_data_exchange_message_marshal(&encoded, frame.data() + 1);
+	frame.resize(static_cast<qsizetype>(1 + octets));
+	return frame;
+}
+
+int64_t time_sync::now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			   std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+}
+
+void ClockSync::addExchange(int64_t t1, int64_t t2, int64_t t3, int64_t t4)
+{
+	Exchange exchange;
+	exchange.offset = ((t2 - t1) + (t3 - t4)) / 2;
+	exchange.roundTrip = (t4 - t1) - (t3 - t2);
+	if (exchange.roundTrip < 0)
+		return; // Timestamps from a broken or lying client
+
+	m_exchanges[m_next] = exchange;
+	m_next = (m_next + 1) % WINDOW;
+	m_count = std::min(m_count + 1, WINDOW);
+
+	const auto best = std::min_element(m_exchanges.begin(),
+									   m_exchanges.begin() + static_cast<std::ptrdiff_t>(m_count),
+									   [](const Exchange &a, const Exchange &b)
+									   {
+										   return a.roundTrip < b.roundTrip;
+									   });
+	m_offset = best->offset;
+	m_roundTrip = best->roundTrip;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "../../VGP_Data_Exchange/C/Colfer.h"
+
+#include <QByteArray>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Control frames for measuring the end-to-end latency of a session.
+ *
+ * @details
+ * A control frame is CONTROL_BYTE followed by a marshalled vgp_data_exchange_message.
+ * CONTROL_BYTE is never the first byte of a gamepad reading, so control frames can be mixed into
+ * the stream of readings (or sent as a datagram of their own) without breaking older servers more
+ * than any other schema mismatch would.
+ *
+ * The text of the message is one of, all times in microseconds:
+ * - `ping <seq> <t1>` client to server, sent right before the reading it stamps.
+ *   t1 is when the client sampled the touch, on the client's clock.
+ * - `pong <seq> <t1> <t2> <ti> <t3>` server to client.
+ *   t2 is when the ping was received, ti when the stamped reading was injected,
+ *   t3 when the pong was sent, all on the server's clock.
+ * - `done <seq> <t4>` client to server, t4 is when the pong was received.
+ *
+ * With all four timestamps the server estimates the clock offset like NTP does,
+ * and with it the latency from t1 to ti.
+ *
+ * The same frames carry the handshake of optional features, a bitmask of CAPABILITY_ values:
+ * - `hello <version> <capabilities>` client to server, what the client can send.
+ * - `welcome <version> <capabilities>` server to client, those the server accepts.
+ *
+ * A server without the handshake counts the hello as an invalid frame and never answers,
+ * so a client keeps sending plain readings until it gets a welcome.
+ */
+namespace time_sync
+{
+constexpr uint8_t CONTROL_BYTE = 0xC5;
+
+/**
+ * Longest control frame accepted, the messages above need less than half of it.
+ */
+constexpr std::size_t MAX_CONTROL_SIZE = 128;
+
+/**
+ * Version of the handshake, sent in hello and welcome.
+ */
+constexpr uint32_t PROTOCOL_VERSION = 1;
+
+/**
+ * Readings may be sent as compact frames, see compact_frame.hpp.
+ */
+constexpr uint32_t CAPABILITY_COMPACT_FRAMES = 1u << 0;
+
+/**
+ * The client sends a reading at least every HEARTBEAT_INTERVAL_MS, the last one again if nothing
+ * changed. The server then releases its inputs once it misses HEARTBEAT_MISSES of them.
+ */
+constexpr uint32_t CAPABILITY_HEARTBEAT = 1u << 1;
+constexpr int HEARTBEAT_INTERVAL_MS = 50;
+constexpr int HEARTBEAT_MISSES = 3;
+
+struct Message
+{
+	enum class Kind
+	{
+		Ping,
+		Pong,
+		Done,
+		Hello,
+		Welcome
+	};
+	Kind kind = Kind::Ping;
+	uint32_t seq = 0;
+	uint32_t version = 0;	   // Hello and Welcome only
+	uint32_t capabilities = 0; // Hello and Welcome only
+	int64_t t1 = 0;
+	int64_t t2 = 0;
+	int64_t ti = 0;
+	int64_t t3 = 0;
+	int64_t t4 = 0;
+};
+
+enum class DecodeResult
+{
+	Ok,
+	Incomplete,
+	Invalid
+};
+
+/**
+ * @brief Decodes a control frame at the start of @p data.
+ * @param consumed Set to the length of the frame, also when it is Invalid.
+ */
+DecodeResult decode(const char *data, std::size_t len, Message &message, std::size_t &consumed);
+
+/**
+ * @brief Encodes a complete control frame, including CONTROL_BYTE.
+ */
+QByteArray encode(const Message &message);
+
+/**
+ * @brief Microseconds on the monotonic clock, the time base of this side of the exchange.
+ */
+int64_t now();
+} // namespace time_sync
+
+/**
+ * @brief Estimates the offset between the client's and the server's clock.
+ *
+ * @details
+ * Every exchange gives an offset estimate `((t2 - t1) + (t3 - t4)) / 2`, exact if the network
+ * delay is the same both ways. Queueing makes one direction slower at times, so like the NTP clock
+ * filter, the estimate of the exchange with the smallest round trip among the last WINDOW is used.
+ */
+class ClockSync
+{
+  public:
+	static constexpr std::size_t WINDOW = 8;
+
+	void addExchange(int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+
+	bool synced() const
+	{
+		return m_count > 0;
+	}
+
+	/**
+	 * @brief Server time minus client time, in microseconds.
+	 */
+	int64_t offset() const
+	{
+		return m_offset;
+	}
+
+	/**
+	 * @brief Network round trip of the exchange the offset comes from, in microseconds.
+	 */
+	int64_t roundTrip() const
+	{
+		return m_roundTrip;
+	}
+
+	int64_t toServerTime(int64_t clientTime) const
+	{
+		return clientTime + m_offset;
+	}
+
+  private:
+	struct Exchange
+	{
+		int64_t offset;
+		int64_t roundTrip;
+	};
+
+	std::array<Exchange, WINDOW> m_exchanges{};
+	std::size_t m_next = 0;
+	std::size_t m_count = 0;
+	int64_t m_offset = 0;
+	int64_t m_roundTrip = 0;
+};
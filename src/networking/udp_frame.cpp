@@ -0,0 +1,81 @@
+#include "udp_frame.hpp"
+
+namespace
+{
+uint32_t read_be32(const uint8_t *p)
+{
+	return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 |
+		   static_cast<uint32_t>(p[2]) << 8 | static_cast<uint32_t>(p[3]);
+}
+
+void write_be32(uint8_t *p, uint32_t v)
+{
+	p[0] = static_cast<uint8_t>(v >> 24);
+	p[1] = static_cast<uint8_t>(v >> 16);
+	p[2] = static_cast<uint8_t>(v >> 8);
+	p[3] = static_cast<uint8_t>(v);
+}
+} // namespace
+
+bool udp_frame::decode(const uint8_t *data, std::size_t len, Frame &frame)
+{
+	if (len <= HEADER_SIZE || len > MAX_DATAGRAM_SIZE)
+		return false;
+	if (data[0] != MAGIC_0 || data[1] != MAGIC_1 || data[2] != VERSION || data[3] != 0)
+		return false;
+
+	frame.sequence = read_be32(data + 4);
+	frame.button_state = read_be32(data + 8);
+	frame.reading = vgp_data_exchange_gamepad_reading{};
+
+	// A datagram holds exactly one reading, trailing bytes are a protocol error
+	std::size_t payload = len - HEADER_SIZE;
+	return vgp_data_exchange_gamepad_reading_unmarshal(&frame.reading, data + HEADER_SIZE, payload) ==
+		   payload;
+}
+
+std::size_t udp_frame::encode(const Frame &frame, uint8_t *buf)
+{
+	buf[0] = MAGIC_0;
+	buf[1] = MAGIC_1;
+	buf[2] = VERSION;
+	buf[3] = 0;
+	write_be32(buf + 4, frame.sequence);
+	write_be32(buf + 8, frame.button_state);
+
+	vgp_data_exchange_gamepad_reading analog = frame.reading;
+	analog.buttons_down = 0;
+	analog.buttons_up = 0;
+	return HEADER_SIZE + vgp_data_exchange_gamepad_reading_marshal(&analog, buf + HEADER_SIZE);
+}
+
+bool UdpSequencer::accept(udp_frame::Frame &frame)
+{
+	if (m_synced)
+	{
+		// Serial number arithmetic, works across the wrap-around
+		auto distance = static_cast<int32_t>(frame.sequence - m_lastSequence);
+		if (distance <= 0 && distance > -RESYNC_WINDOW)
+		{
+			m_staleCount++;
+			return false;
+		}
+		if (distance > 1 && distance < RESYNC_WINDOW)
+			m_lostCount += static_cast<uint64_t>(distance - 1);
+	}
+
+	m_synced = true;
+	m_lastSequence = frame.sequence;
+
+	frame.reading.buttons_down = frame.button_state & ~m_buttonState;
+	frame.reading.buttons_up = m_buttonState & ~frame.button_state;
+	m_buttonState = frame.button_state;
+	return true;
+}
+
+void UdpSequencer::reset()
+{
+	m_synced = false;
+	m_lastSequence = 0;
+	m_buttonState = 0;
+}
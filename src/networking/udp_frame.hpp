@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../../VGP_Data_Exchange/C/Colfer.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file udp_frame.hpp
+ * @brief Datagram format of the UDP transport.
+ *
+ * @details
+ * Every datagram carries one complete gamepad state, so a lost datagram only loses
+ * an intermediate state instead of stalling every later one (no head-of-line blocking).
+ *
+ * | Offset | Size | Field                                                        |
+ * |--------|------|--------------------------------------------------------------|
+ * | 0      | 2    | Magic `VG`                                                   |
+ * | 2      | 1    | Version, currently 1                                         |
+ * | 3      | 1    | Flags, reserved, must be 0                                   |
+ * | 4      | 4    | Sequence number, big-endian, wraps around                    |
+ * | 8      | 4    | Absolute button state (GamepadButtons bits held), big-endian |
+ * | 12     | n    | Colfer encoded `vgp_data_exchange_gamepad_reading`           |
+ *
+ * The `buttons_down`/`buttons_up` fields of the Colfer payload are ignored,
+ * the edges are derived from the absolute button state on the server side.
+ */
+namespace udp_frame
+{
+constexpr uint8_t MAGIC_0 = 'V';
+constexpr uint8_t MAGIC_1 = 'G';
+constexpr uint8_t VERSION = 1;
+constexpr std::size_t HEADER_SIZE = 12;
+/**
+ * Upper bound of a datagram we accept. A marshalled reading is at most 45 bytes.
+ */
+constexpr std::size_t MAX_DATAGRAM_SIZE = 128;
+
+struct Frame
+{
+	uint32_t sequence = 0;
+	uint32_t button_state = 0;
+	vgp_data_exchange_gamepad_reading reading{};
+};
+
+/**
+ * @brief Decodes a datagram.
+ *
+ * @return false if the datagram is malformed.
+ */
+bool decode(const uint8_t *data, std::size_t len, Frame &frame);
+
+/**
+ * @brief Encodes a datagram (used by clients and test tools).
+ *
+ * @param buf At least MAX_DATAGRAM_SIZE bytes
+ * @return The datagram size in bytes.
+ */
+std::size_t encode(const Frame &frame, uint8_t *buf);
+} // namespace udp_frame
+
+/**
+ * @brief Turns a stream of sequence-numbered absolute states into gamepad readings.
+ *
+ * @details
+ * Latest state wins: frames older than (or equal to) the newest accepted one are stale and dropped,
+ * including their analog values. Button edges are derived from the difference between the last
+ * accepted button state and the new one, so a lost datagram can never leave a button stuck.
+ */
+class UdpSequencer
+{
+  public:
+	/**
+	 * A frame this far behind the newest one is taken as a client restart instead of a stale frame.
+	 */
+	static constexpr int32_t RESYNC_WINDOW = 1024;
+
+	/**
+	 * @brief Accepts a frame.
+	 *
+	 * @param frame The decoded frame. On success its reading gets the derived button edges.
+	 * @return false if the frame is stale and must be dropped.
+	 */
+	bool accept(udp_frame::Frame &frame);
+
+	/**
+	 * @brief Forgets the session, the next frame is accepted unconditionally.
+	 */
+	void reset();
+
+	/**
+	 * @brief Forgets the held buttons, the next frame presses those still held again.
+	 */
+	void releaseButtons()
+	{
+		m_buttonState = 0;
+	}
+
+	uint32_t buttonState() const
+	{
+		return m_buttonState;
+	}
+
+	/**
+	 * Sequence number of the newest accepted frame.
+	 */
+	uint32_t lastSequence() const
+	{
+		return m_lastSequence;
+	}
+
+	uint64_t staleCount() const
+	{
+		return m_staleCount;
+	}
+
+	/**
+	 * Frames never received, computed from gaps in the sequence numbers.
+	 */
+	uint64_t lostCount() const
+	{
+		return m_lostCount;
+	}
+
+  private:
+	bool m_synced = false;
+	uint32_t m_lastSequence = 0;
+	uint32_t m_buttonState = 0;
+	uint64_t m_staleCount = 0;
+	uint64_t m_lostCount = 0;
+};
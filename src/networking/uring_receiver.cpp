@@ -0,0 +1,521 @@
+#include "uring_receiver.hpp"
+
+#ifdef VGP_HAVE_IO_URING
+
+#include <QDebug>
+#include <QSocketNotifier>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <liburing.h>
+#include <map>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+constexpr quint64 DATAGRAM_KEY = 0;			// user_data of the datagram socket's receive
+constexpr quint64 PROBE_KEY = ~quint64{0}; // user_data of the receive open() tests the kernel with
+constexpr uint16_t BUFFER_GROUP = 0;
+
+QString errorString(int error)
+{
+	return QString::fromLocal8Bit(std::strerror(error));
+}
+
+/**
+ * @brief @p address and @p port for a socket of @p family, IPv4 addresses mapped into IPv6 for AF_INET6.
+ * @return The length of the address written to @p result.
+ */
+socklen_t socketAddress(const QHostAddress &address, quint16 port, int family, sockaddr_storage &result)
+{
+	result = sockaddr_storage{};
+	if (family == AF_INET6)
+	{
+		auto &ipv6 = reinterpret_cast<sockaddr_in6 &>(result);
+		ipv6.sin6_family = AF_INET6;
+		const Q_IPV6ADDR bytes = address.toIPv6Address();
+		std::memcpy(&ipv6.sin6_addr, bytes.c, sizeof(ipv6.sin6_addr));
+		ipv6.sin6_port = htons(port);
+		return sizeof(sockaddr_in6);
+	}
+	auto &ipv4 = reinterpret_cast<sockaddr_in &>(result);
+	ipv4.sin_family = AF_INET;
+	ipv4.sin_addr.s_addr = htonl(address.toIPv4Address());
+	ipv4.sin_port = htons(port);
+	return sizeof(sockaddr_in);
+}
+
+/**
+ * @brief Port of an AF_INET or AF_INET6 address.
+ */
+quint16 socketPort(const sockaddr *address)
+{
+	if (address->sa_family == AF_INET6)
+		return ntohs(reinterpret_cast<const sockaddr_in6 *>(address)->sin6_port);
+	return ntohs(reinterpret_cast<const sockaddr_in *>(address)->sin_port);
+}
+} // namespace
+
+struct UringReceiver::State
+{
+	io_uring ring{};
+	bool ringReady = false;
+	io_uring_buf_ring *buffers = nullptr;
+	std::vector<char> storage; // BUFFER_COUNT buffers of BUFFER_SIZE bytes
+	std::unique_ptr<QSocketNotifier> notifier;
+
+	std::map<quint64, int> streams; // Key to descriptor
+	int datagramSocket = -1;
+	int datagramFamily = AF_INET;
+	quint16 datagramPort = 0;
+	msghdr datagramHeader{}; // Only tells the multishot receive how much room to leave for the address
+
+	std::vector<quint64> rearm; // Receives the kernel ended during one drain()
+	uint64_t completions = 0;
+	uint64_t wakeups = 0;
+
+	~State()
+	{
+		notifier.reset();
+		if (ringReady)
+		{
+			// Cancels whatever is still in flight
+			if (buffers != nullptr)
+				io_uring_free_buf_ring(&ring, buffers, BUFFER_COUNT, BUFFER_GROUP);
+			io_uring_queue_exit(&ring);
+		}
+		for (const auto &[key, descriptor] : streams)
+			::close(descriptor);
+		if (datagramSocket >= 0)
+			::close(datagramSocket);
+	}
+};
+
+UringReceiver::UringReceiver(Handlers handlers)
+	: m_handlers(std::move(handlers)), m_state(std::make_unique<State>())
+{
+}
+
+UringReceiver::~UringReceiver() = default;
+
+bool UringReceiver::open(QString &error)
+{
+	State &state = *m_state;
+
+	// Room for a completion per buffer and then some, a burst never overflows the completion queue
+	io_uring_params params{};
+	params.flags = IORING_SETUP_CQSIZE;
+	params.cq_entries = 2 * BUFFER_COUNT;
+	int result = io_uring_queue_init_params(QUEUE_DEPTH, &state.ring, &params);
+	if (result < 0)
+	{
+		// ENOSYS without io_uring, EPERM where the kernel.io_uring_disabled sysctl forbids it
+		error = errorString(-result);
+		return false;
+	}
+	state.ringReady = true;
+
+	state.storage.resize(BUFFER_COUNT * BUFFER_SIZE);
+	state.buffers = io_uring_setup_buf_ring(&state.ring, BUFFER_COUNT, BUFFER_GROUP, 0, &result);
+	if (state.buffers == nullptr)
+	{
+		// EINVAL before Linux 5.19, which brought the buffer rings
+		error = result == -EINVAL
+					? QStringLiteral("the kernel has no buffer rings (Linux 5.19 or later is needed)")
+					: errorString(-result);
+		return false;
+	}
+	const int mask = io_uring_buf_ring_mask(BUFFER_COUNT);
+	for (unsigned i = 0; i < BUFFER_COUNT; i++)
+	{
+		io_uring_buf_ring_add(state.buffers,
+							  state.storage.data() + i * BUFFER_SIZE,
+							  BUFFER_SIZE,
+							  static_cast<unsigned short>(i),
+							  mask,
+							  static_cast<int>(i));
+	}
+	io_uring_buf_ring_advance(state.buffers, BUFFER_COUNT);
+
+	result = probeMultishot();
+	if (result != 0)
+	{
+		// No opcode tells multishot receive apart, a kernel without it fails the receive with EINVAL
+		error = result == -EINVAL
+					? QStringLiteral("the kernel has no multishot receive (Linux 6.0 or later is needed)")
+					: errorString(-result);
+		return false;
+	}
+
+	// The ring is readable while completions are waiting
+	state.notifier = std::make_unique<QSocketNotifier>(state.ring.ring_fd, QSocketNotifier::Read);
+	QObject::connect(state.notifier.get(),
+					 &QSocketNotifier::activated,
+					 [this]()
+					 {
+						 drain();
+					 });
+	return true;
+}
+
+bool UringReceiver::listenDatagrams(const QHostAddress &address, quint16 port, QString &error)
+{
+	State &state = *m_state;
+	const bool ipv4 = address.protocol() == QAbstractSocket::IPv4Protocol;
+	state.datagramFamily = ipv4 ? AF_INET : AF_INET6;
+	state.datagramSocket = ::socket(state.datagramFamily, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (state.datagramSocket < 0)
+	{
+		error = errorString(errno);
+		return false;
+	}
+	if (!ipv4)
+	{
+		// Like QUdpSocket, QHostAddress::Any is dual-stack and QHostAddress::AnyIPv6 is IPv6 only
+		const int ipv6Only = address.protocol() == QAbstractSocket::IPv6Protocol ? 1 : 0;
+		::setsockopt(state.datagramSocket, IPPROTO_IPV6, IPV6_V6ONLY, &ipv6Only, sizeof(ipv6Only));
+	}
+
+	sockaddr_storage local{};
+	const socklen_t localLength = socketAddress(address, port, state.datagramFamily, local);
+	sockaddr_storage bound{};
+	socklen_t boundLength = sizeof(bound);
+	if (::bind(state.datagramSocket, reinterpret_cast<const sockaddr *>(&local), localLength) != 0 ||
+		::getsockname(state.datagramSocket, reinterpret_cast<sockaddr *>(&bound), &boundLength) != 0)
+	{
+		error = errorString(errno);
+		return false;
+	}
+	state.datagramPort = socketPort(reinterpret_cast<const sockaddr *>(&bound));
+
+	state.datagramHeader.msg_namelen = ipv4 ? sizeof(sockaddr_in) : sizeof(sockaddr_in6);
+	if (!arm(DATAGRAM_KEY))
+	{
+		error = QStringLiteral("the submission queue is full");
+		return false;
+	}
+	submit();
+	return true;
+}
+
+quint16 UringReceiver::datagramPort() const
+{
+	return m_state->datagramPort;
+}
+
+qintptr UringReceiver::datagramDescriptor() const
+{
+	return m_state->datagramSocket;
+}
+
+bool UringReceiver::sendDatagram(const QByteArray &bytes, const QHostAddress &receiver, quint16 port)
+{
+	sockaddr_storage address{};
+	const socklen_t addressLength = socketAddress(receiver, port, m_state->datagramFamily, address);
+	return ::sendto(m_state->datagramSocket,
+					bytes.constData(),
+					static_cast<std::size_t>(bytes.size()),
+					MSG_DONTWAIT,
+					reinterpret_cast<const sockaddr *>(&address),
+					addressLength) == bytes.size();
+}
+
+bool UringReceiver::watchStream(qintptr descriptor, quint64 key)
+{
+	State &state = *m_state;
+	const int socket = static_cast<int>(descriptor);
+	// Same as QAbstractSocket::LowDelayOption on the Qt path
+	const int noDelay = 1;
+	::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+	state.streams.emplace(key, socket);
+	if (!arm(key))
+	{
+		state.streams.erase(key);
+		return false;
+	}
+	submit();
+	return true;
+}
+
+bool UringReceiver::sendStream(quint64 key, const QByteArray &bytes)
+{
+	auto it = m_state->streams.find(key);
+	if (it == m_state->streams.end())
+		return false;
+	// Control frames are far smaller than the socket buffer, only a client that stopped reading
+	// can make this fail, and its answers do not matter anymore
+	return ::send(it->second,
+				  bytes.constData(),
+				  static_cast<std::size_t>(bytes.size()),
+				  MSG_DONTWAIT | MSG_NOSIGNAL) == bytes.size();
+}
+
+void UringReceiver::closeStream(quint64 key)
+{
+	auto it = m_state->streams.find(key);
+	if (it == m_state->streams.end())
+		return;
+	// The receive in flight holds its own reference to the socket, closing the descriptor would not
+	// end it. A shutdown completes it with end of stream, which is ignored once the key is gone.
+	::shutdown(it->second, SHUT_RDWR);
+	::close(it->second);
+	m_state->streams.erase(it);
+}
+
+bool UringReceiver::peerAddress(qintptr descriptor, QHostAddress &address, quint16 &port)
+{
+	sockaddr_storage peer{};
+	socklen_t peerLength = sizeof(peer);
+	if (::getpeername(static_cast<int>(descriptor), reinterpret_cast<sockaddr *>(&peer), &peerLength) != 0)
+		return false;
+	if (peer.ss_family != AF_INET && peer.ss_family != AF_INET6)
+		return false;
+	address.setAddress(reinterpret_cast<const sockaddr *>(&peer));
+	port = socketPort(reinterpret_cast<const sockaddr *>(&peer));
+	return true;
+}
+
+uint64_t UringReceiver::completionCount() const
+{
+	return m_state->completions;
+}
+
+uint64_t UringReceiver::wakeupCount() const
+{
+	return m_state->wakeups;
+}
+
+void UringReceiver::drain()
+{
+	State &state = *m_state;
+	state.wakeups++;
+	state.rearm.clear();
+
+	const int mask = io_uring_buf_ring_mask(BUFFER_COUNT);
+	int recycled = 0;
+	unsigned seen = 0;
+	unsigned head = 0;
+	io_uring_cqe *cqe = nullptr;
+	io_uring_for_each_cqe(&state.ring, head, cqe)
+	{
+		seen++;
+		const quint64 key = io_uring_cqe_get_data64(cqe);
+		const bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+		char *buffer = nullptr;
+		unsigned short bufferId = 0;
+		if ((cqe->flags & IORING_CQE_F_BUFFER) != 0)
+		{
+			bufferId = static_cast<unsigned short>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+			buffer = state.storage.data() + bufferId * BUFFER_SIZE;
+		}
+
+		if (key == DATAGRAM_KEY)
+		{
+			io_uring_recvmsg_out *message =
+				buffer != nullptr ? io_uring_recvmsg_validate(buffer, cqe->res, &state.datagramHeader)
+								  : nullptr;
+			// The sender is an AF_INET or AF_INET6 address, like the socket
+			if (message != nullptr && message->namelen >= sizeof(sockaddr_in)) [[likely]]
+			{
+				const auto *sender = static_cast<const sockaddr *>(io_uring_recvmsg_name(message));
+				const QHostAddress address(sender);
+				// A truncated datagram is still longer than any datagram we accept
+				m_handlers.datagram(
+					address,
+					socketPort(sender),
+					static_cast<const uint8_t *>(io_uring_recvmsg_payload(message, &state.datagramHeader)),
+					io_uring_recvmsg_payload_length(message, cqe->res, &state.datagramHeader));
+			}
+			if (!more && cqe->res != -ECANCELED)
+				state.rearm.push_back(key);
+		}
+		else if (state.streams.contains(key)) // Otherwise closed meanwhile, or PROBE_KEY
+		{
+			if (cqe->res > 0) [[likely]]
+			{
+				m_handlers.stream(key, buffer, static_cast<std::size_t>(cqe->res));
+				// The handler may have closed the stream
+				if (!more && state.streams.contains(key))
+					state.rearm.push_back(key);
+			}
+			else if (cqe->res == -ENOBUFS)
+			{
+				// Every buffer was in use, the ones handled here are given back below
+				state.rearm.push_back(key);
+			}
+			else
+			{
+				// End of stream, or the connection failed
+				closeStream(key);
+				m_handlers.streamClosed(key);
+			}
+		}
+
+		// Only visible to the kernel after the advance below
+		if (buffer != nullptr)
+			io_uring_buf_ring_add(state.buffers, buffer, BUFFER_SIZE, bufferId, mask, recycled++);
+	}
+	io_uring_buf_ring_advance(state.buffers, recycled);
+	io_uring_cq_advance(&state.ring, seen);
+	state.completions += seen;
+
+	for (quint64 key : state.rearm)
+	{
+		if (!arm(key))
+			qWarning() << "io_uring submission queue full, stopped receiving on" << key;
+	}
+	submit();
+}
+
+int UringReceiver::probeMultishot()
+{
+	State &state = *m_state;
+	int pair[2];
+	if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, pair) != 0)
+		return -errno;
+
+	// A byte is waiting, so the receive completes right away instead of staying armed
+	const char byte = 0;
+	int result = ::send(pair[1], &byte, 1, MSG_NOSIGNAL) == 1 ? 0 : -errno;
+	io_uring_sqe *sqe = result == 0 ? io_uring_get_sqe(&state.ring) : nullptr;
+	if (sqe != nullptr)
+	{
+		io_uring_prep_recv_multishot(sqe, pair[0], nullptr, 0, 0);
+		sqe->flags |= IOSQE_BUFFER_SELECT;
+		sqe->buf_group = BUFFER_GROUP;
+		io_uring_sqe_set_data64(sqe, PROBE_KEY);
+
+		io_uring_cqe *cqe = nullptr;
+		result = io_uring_submit_and_wait(&state.ring, 1);
+		if (result >= 0)
+			result = io_uring_peek_cqe(&state.ring, &cqe);
+		if (result == 0)
+		{
+			result = std::min(cqe->res, 0);
+			if ((cqe->flags & IORING_CQE_F_BUFFER) != 0)
+			{
+				const auto bufferId = static_cast<unsigned short>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+				io_uring_buf_ring_add(state.buffers,
+									  state.storage.data() + bufferId * BUFFER_SIZE,
+									  BUFFER_SIZE,
+									  bufferId,
+									  io_uring_buf_ring_mask(BUFFER_COUNT),
+									  0);
+				io_uring_buf_ring_advance(state.buffers, 1);
+			}
+			io_uring_cqe_seen(&state.ring, cqe);
+		}
+	}
+	else if (result == 0)
+		result = -EBUSY;
+
+	// Ends the receive where it stayed armed, drain() ignores its last completion
+	::shutdown(pair[0], SHUT_RDWR);
+	::close(pair[0]);
+	::close(pair[1]);
+	return result;
+}
+
+bool UringReceiver::arm(quint64 key)
+{
+	State &state = *m_state;
+	io_uring_sqe *sqe = io_uring_get_sqe(&state.ring);
+	if (sqe == nullptr)
+		return false;
+	if (key == DATAGRAM_KEY)
+		io_uring_prep_recvmsg_multishot(sqe, state.datagramSocket, &state.datagramHeader, 0);
+	else
+		io_uring_prep_recv_multishot(sqe, state.streams.at(key), nullptr, 0, 0);
+	// The kernel picks a buffer from the ring for every completion
+	sqe->flags |= IOSQE_BUFFER_SELECT;
+	sqe->buf_group = BUFFER_GROUP;
+	io_uring_sqe_set_data64(sqe, key);
+	return true;
+}
+
+void UringReceiver::submit()
+{
+	if (io_uring_sq_ready(&m_state->ring) == 0)
+		return;
+	const int result = io_uring_submit(&m_state->ring);
+	if (result < 0)
+		qWarning() << "io_uring submission failed:" << errorString(-result);
+}
+
+#else
+
+// Built without io_uring, open() fails and nothing else is ever called
+
+struct UringReceiver::State
+{
+};
+
+UringReceiver::UringReceiver(Handlers handlers) : m_handlers(std::move(handlers))
+{
+}
+
+UringReceiver::~UringReceiver() = default;
+
+bool UringReceiver::open(QString &error)
+{
+	error = QStringLiteral("built without io_uring support");
+	return false;
+}
+
+bool UringReceiver::listenDatagrams(const QHostAddress &, quint16, QString &error)
+{
+	error = QStringLiteral("built without io_uring support");
+	return false;
+}
+
+quint16 UringReceiver::datagramPort() const
+{
+	return 0;
+}
+
+qintptr UringReceiver::datagramDescriptor() const
+{
+	return -1;
+}
+
+bool UringReceiver::sendDatagram(const QByteArray &, const QHostAddress &, quint16)
+{
+	return false;
+}
+
+bool UringReceiver::watchStream(qintptr, quint64)
+{
+	return false;
+}
+
+bool UringReceiver::sendStream(quint64, const QByteArray &)
+{
+	return false;
+}
+
+void UringReceiver::closeStream(quint64)
+{
+}
+
+bool UringReceiver::peerAddress(qintptr, QHostAddress &, quint16 &)
+{
+	return false;
+}
+
+uint64_t UringReceiver::completionCount() const
+{
+	return 0;
+}
+
+uint64_t UringReceiver::wakeupCount() const
+{
+	return 0;
+}
+
+#endif
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+/**
+ * @brief Receives from the server's sockets through io_uring instead of the Qt event dispatcher.
+ *
+ * @details
+ * Every socket has one multishot receive in flight: the kernel completes it again for every
+ * segment or datagram that arrives, into a buffer it picks from a ring of BUFFER_COUNT buffers
+ * shared with us, without any syscall of ours. The ring itself is watched by a QSocketNotifier,
+ * so one wakeup of the network thread handles every completion that piled up since the last one.
+ * The Qt path needs a wakeup, a read and a pending data check for every datagram.
+ *
+ * The sockets served this way are plain descriptors owned by the receiver, Qt never sees them.
+ * Replies are rare and tiny, they are sent with a plain non-blocking send.
+ *
+ * Only available on Linux 6.0 or later, in builds with `-DVGP_ENABLE_IO_URING=ON` that found
+ * liburing. Elsewhere, or where io_uring is disabled, open() fails and the caller keeps using
+ * the Qt sockets.
+ */
+class UringReceiver
+{
+  public:
+	static constexpr unsigned QUEUE_DEPTH = 64;
+	static constexpr unsigned BUFFER_COUNT = 256; // A power of two, like every io_uring ring
+	static constexpr std::size_t BUFFER_SIZE = 2048;
+
+	struct Handlers
+	{
+		// Bytes received on the stream of a key
+		std::function<void(quint64 key, const char *data, std::size_t len)> stream;
+		// The stream of a key was closed by the peer or failed, it is no longer watched
+		std::function<void(quint64 key)> streamClosed;
+		// A datagram received on the datagram socket, with its sender's address and port
+		std::function<void(const QHostAddress &, quint16, const uint8_t *data, std::size_t len)> datagram;
+	};
+
+	explicit UringReceiver(Handlers handlers);
+	~UringReceiver();
+
+	// Delete copy and move operations, the kernel holds pointers into this object
+	UringReceiver(const UringReceiver &) = delete;
+	UringReceiver &operator=(const UringReceiver &) = delete;
+	UringReceiver(UringReceiver &&) = delete;
+	UringReceiver &operator=(UringReceiver &&) = delete;
+
+	/**
+	 * @brief Sets up the ring. Must run on the thread that handles the completions.
+	 * @return false if io_uring cannot be used here, @p error says why.
+	 */
+	bool open(QString &error);
+
+	/**
+	 * @brief Binds the datagram socket to @p address and @p port and starts receiving.
+	 * QHostAddress::Any binds both IPv4 and IPv6, like QUdpSocket does.
+	 */
+	bool listenDatagrams(const QHostAddress &address, quint16 port, QString &error);
+
+	/**
+	 * @brief Port the datagram socket is bound to, the one picked by the system if 0 was asked for.
+	 */
+	quint16 datagramPort() const;
+
+	/**
+	 * @brief Descriptor of the datagram socket, to set socket options, -1 before listenDatagrams().
+	 */
+	qintptr datagramDescriptor() const;
+
+	bool sendDatagram(const QByteArray &bytes, const QHostAddress &receiver, quint16 port);
+
+	/**
+	 * @brief Takes over an accepted TCP connection and starts receiving from it.
+	 * @param key Passed to the handlers, any value but 0.
+	 * @return false if it could not be watched, the caller still owns the descriptor then.
+	 */
+	bool watchStream(qintptr descriptor, quint64 key);
+
+	bool sendStream(quint64 key, const QByteArray &bytes);
+
+	/**
+	 * @brief Stops receiving from the stream of @p key and closes the connection.
+	 */
+	void closeStream(quint64 key);
+
+	/**
+	 * @brief Address and port of the peer of a connected socket.
+	 */
+	static bool peerAddress(qintptr descriptor, QHostAddress &address, quint16 &port);
+
+	/**
+	 * @brief Completions handled, and wakeups of the network thread it took.
+	 */
+	uint64_t completionCount() const;
+	uint64_t wakeupCount() const;
+
+  private:
+	struct State;
+
+	void drain();
+	/**
+	 * @brief Arms a multishot receive on a socket pair, 0 if the kernel supports it, -errno otherwise.
+	 */
+	int probeMultishot();
+	bool arm(quint64 key);
+	void submit();
+
+	Handlers m_handlers;
+	std::unique_ptr<State> m_state;
+};
@@ -0,0 +1,187 @@
+#include "axis_response.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AXIS_RESPONSE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+/**
+ * Smallest magnitude divided by, the output of a centred axis is 0 whatever its scale.
+ */
+constexpr float MIN_MAGNITUDE = 1e-6f;
+
+/**
+ * @brief Conditions @p value of magnitude @p magnitude with @p table, like the SIMD kernel does per lane.
+ */
+float condition(float value,
+				float magnitude,
+				const std::array<AxisTables::Entry, AxisTables::LUT_SIZE> &table)
+{
+	// Operands in the order of _mm_max_ps and _mm_min_ps, a NaN magnitude gives MIN_MAGNITUDE on both paths
+	const float clamped = std::min(1.0f, std::max(MIN_MAGNITUDE, magnitude));
+	const float position = clamped * static_cast<float>(AxisTables::LUT_SIZE);
+	const int segment = std::min(static_cast<int>(position), static_cast<int>(AxisTables::LUT_SIZE) - 1);
+	const float fraction = position - static_cast<float>(segment);
+	const AxisTables::Entry &entry = table[static_cast<std::size_t>(segment)];
+	const float output = entry.value + fraction * entry.slope;
+	return std::min(std::max(value * output / clamped, -1.0f), 1.0f);
+}
+
+#ifdef AXIS_RESPONSE_SSE2
+/**
+ * @brief condition() on four lanes, lane i looked up in @p tables[i].
+ */
+__m128 condition(__m128 values, __m128 magnitudes, const AxisTables::Entry *const (&tables)[4])
+{
+	const __m128 clamped =
+		_mm_min_ps(_mm_max_ps(magnitudes, _mm_set1_ps(MIN_MAGNITUDE)), _mm_set1_ps(1.0f));
+	const __m128 position = _mm_mul_ps(clamped, _mm_set1_ps(static_cast<float>(AxisTables::LUT_SIZE)));
+	__m128i segments = _mm_cvttps_epi32(position);
+	// No _mm_min_epi32 before SSE4.1, the comparison is -1 where the segment is past the last one
+	const __m128i last = _mm_set1_epi32(static_cast<int>(AxisTables::LUT_SIZE) - 1);
+	segments = _mm_add_epi32(segments, _mm_cmpgt_epi32(segments, last));
+	const __m128 fractions = _mm_sub_ps(position, _mm_cvtepi32_ps(segments));
+
+	alignas(16) int32_t index[4];
+	_mm_store_si128(reinterpret_cast<__m128i *>(index), segments);
+	const AxisTables::Entry &e0 = tables[0][index[0]];
+	const AxisTables::Entry &e1 = tables[1][index[1]];
+	const AxisTables::Entry &e2 = tables[2][index[2]];
+	const AxisTables::Entry &e3 = tables[3][index[3]];
+	const __m128 starts = _mm_setr_ps(e0.value, e1.value, e2.value, e3.value);
+	const __m128 slopes = _mm_setr_ps(e0.slope, e1.slope, e2.slope, e3.slope);
+	const __m128 outputs = _mm_add_ps(starts, _mm_mul_ps(fractions, slopes));
+
+	const __m128 scaled = _mm_div_ps(_mm_mul_ps(values, outputs), clamped);
+	return _mm_min_ps(_mm_max_ps(scaled, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+}
+#endif
+} // namespace
+
+AxisResponse AxisResponse::sanitized() const
+{
+	AxisResponse result = *this;
+	result.deadzone = std::clamp(deadzone, 0.0f, 0.9f);
+	result.antiDeadzone = std::clamp(antiDeadzone, 0.0f, 0.9f);
+	result.saturation = std::clamp(saturation, result.deadzone + 0.05f, 1.0f);
+	result.exponent = std::clamp(exponent, 0.1f, 10.0f);
+	result.bezier1 = std::clamp(bezier1, 0.0f, 1.0f);
+	result.bezier2 = std::clamp(bezier2, 0.0f, 1.0f);
+	return result;
+}
+
+float AxisResponse::evaluate(float magnitude) const
+{
+	if (magnitude <= deadzone)
+		return 0.0f;
+	if (magnitude >= saturation)
+		return 1.0f;
+
+	const float t = (magnitude - deadzone) / (saturation - deadzone);
+	float shaped = t;
+	if (curve == Curve::Bezier)
+	{
+		// The control points are evenly spaced across, so the curve is a function of t
+		const float u = 1.0f - t;
+		shaped = 3.0f * u * u * t * bezier1 + 3.0f * u * t * t * bezier2 + t * t * t;
+	}
+	else if (exponent != 1.0f)
+		shaped = std::pow(t, exponent);
+	return antiDeadzone + (1.0f - antiDeadzone) * shaped;
+}
+
+AxisTables AxisTables::compile(const AxisResponse &leftStick,
+							   const AxisResponse &rightStick,
+							   const AxisResponse &leftTrigger,
+							   const AxisResponse &rightTrigger)
+{
+	AxisTables result;
+	const AxisResponse responses[4] = {leftStick.sanitized(),
+									   rightStick.sanitized(),
+									   leftTrigger.sanitized(),
+									   rightTrigger.sanitized()};
+	for (std::size_t i = 0; i < 4; i++)
+	{
+		auto &table = result.tables[i];
+		float start = responses[i].evaluate(0.0f);
+		for (std::size_t segment = 0; segment < LUT_SIZE; segment++)
+		{
+			const float end =
+				responses[i].evaluate(static_cast<float>(segment + 1) / static_cast<float>(LUT_SIZE));
+			table[segment] = {start, end - start};
+			start = end;
+		}
+		result.enabled = result.enabled || responses[i] != AxisResponse{};
+	}
+	result.radial = {responses[0].shape == AxisResponse::Shape::Radial,
+					 responses[1].shape == AxisResponse::Shape::Radial};
+	return result;
+}
+
+void AxisTables::apply(float (&axes)[AXIS_COUNT]) const
+{
+#ifdef AXIS_RESPONSE_SSE2
+	const __m128 absolute = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const __m128 infinity = _mm_set1_ps(std::numeric_limits<float>::infinity());
+
+	// Both sticks, the radial magnitude of a lane adds the square of the other axis of its stick.
+	// NaN and infinite axes are centred first, the comparison is false for both.
+	__m128 sticks = _mm_loadu_ps(&axes[LeftX]);
+	sticks = _mm_and_ps(sticks, _mm_cmplt_ps(_mm_and_ps(sticks, absolute), infinity));
+	const __m128 squares = _mm_mul_ps(sticks, sticks);
+	const __m128 radialMagnitudes =
+		_mm_sqrt_ps(_mm_add_ps(squares, _mm_shuffle_ps(squares, squares, _MM_SHUFFLE(2, 3, 0, 1))));
+	const __m128 radialLanes = _mm_castsi128_ps(
+		_mm_setr_epi32(-int{radial[0]}, -int{radial[0]}, -int{radial[1]}, -int{radial[1]}));
+	const __m128 stickMagnitudes = _mm_or_ps(_mm_and_ps(radialLanes, radialMagnitudes),
+											 _mm_andnot_ps(radialLanes, _mm_and_ps(sticks, absolute)));
+	const AxisTables::Entry *const stickTables[4] = {tables[0].data(),
+													 tables[0].data(),
+													 tables[1].data(),
+													 tables[1].data()};
+	_mm_storeu_ps(&axes[LeftX], condition(sticks, stickMagnitudes, stickTables));
+
+	// Both triggers, in the two low lanes
+	__m128 triggers = _mm_setr_ps(axes[LeftTrigger], axes[RightTrigger], 0.0f, 0.0f);
+	triggers = _mm_and_ps(triggers, _mm_cmplt_ps(_mm_and_ps(triggers, absolute), infinity));
+	const AxisTables::Entry *const triggerTables[4] = {tables[2].data(),
+													   tables[3].data(),
+													   tables[2].data(),
+													   tables[3].data()};
+	alignas(16) float conditioned[4];
+	_mm_store_ps(conditioned, condition(triggers, _mm_and_ps(triggers, absolute), triggerTables));
+	axes[LeftTrigger] = conditioned[0];
+	axes[RightTrigger] = conditioned[1];
+#else
+	applyScalar(axes);
+#endif
+}
+
+void AxisTables::applyScalar(float (&axes)[AXIS_COUNT]) const
+{
+	// Like apply(), NaN and infinite axes are centred
+	for (float &axis : axes)
+	{
+		if (!std::isfinite(axis)) [[unlikely]]
+			axis = 0.0f;
+	}
+
+	for (std::size_t stick = 0; stick < 2; stick++)
+	{
+		float &x = axes[LeftX + 2 * stick];
+		float &y = axes[LeftY + 2 * stick];
+		const float radialMagnitude = std::sqrt(x * x + y * y);
+		const float magnitudeX = radial[stick] ? radialMagnitude : std::abs(x);
+		const float magnitudeY = radial[stick] ? radialMagnitude : std::abs(y);
+		x = condition(x, magnitudeX, tables[stick]);
+		y = condition(y, magnitudeY, tables[stick]);
+	}
+	axes[LeftTrigger] = condition(axes[LeftTrigger], std::abs(axes[LeftTrigger]), tables[2]);
+	axes[RightTrigger] = condition(axes[RightTrigger], std::abs(axes[RightTrigger]), tables[3]);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Conditioning of an analog input: deadzones, saturation and response curve.
+ *
+ * @details
+ * The response maps the magnitude of the input, in [0, 1], to the magnitude of the output:
+ * - below the deadzone, the output is 0;
+ * - past it, the output starts at the anti-deadzone, to get past the deadzone of the game itself;
+ * - at the saturation and above, the output is 1;
+ * - in between, it follows the curve.
+ *
+ * The magnitude of a stick is its distance from the center with a radial deadzone, and each axis
+ * on its own with an axial one. The defaults leave the input unchanged.
+ */
+struct AxisResponse
+{
+	enum class Shape : uint8_t
+	{
+		Radial,
+		Axial
+	};
+
+	enum class Curve : uint8_t
+	{
+		Exponent, // magnitude ^ exponent
+		Bezier	  // Cubic Bezier from (0, 0) to (1, 1)
+	};
+
+	Shape shape = Shape::Radial; // Sticks only
+	float deadzone = 0.0f;
+	float antiDeadzone = 0.0f;
+	float saturation = 1.0f;
+	Curve curve = Curve::Exponent;
+	float exponent = 1.0f;
+	// Heights of the two inner control points of the Bezier curve, at 1/3 and 2/3 of the way across
+	float bezier1 = 1.0f / 3.0f;
+	float bezier2 = 2.0f / 3.0f;
+
+	bool operator==(const AxisResponse &) const = default;
+
+	/**
+	 * @brief Clamps every field to its range, the saturation stays above the deadzone.
+	 */
+	AxisResponse sanitized() const;
+
+	/**
+	 * @brief Output magnitude for the input magnitude @p magnitude, in [0, 1].
+	 */
+	float evaluate(float magnitude) const;
+};
+
+/**
+ * @brief The responses of both sticks and both triggers, compiled into lookup tables.
+ *
+ * @details
+ * apply() conditions the six axes of a reading at once: the magnitude of every axis, one table lookup
+ * each, interpolated, and the axis scaled by the ratio of the output to the input magnitude.
+ * It runs on SSE2 where available, the scalar path computes the same. Both take NaN and infinite
+ * axes as centred, so a corrupt reading cannot index outside the tables.
+ */
+struct AxisTables
+{
+	/**
+	 * Order of the values given to apply().
+	 */
+	enum Axis
+	{
+		LeftX,
+		LeftY,
+		RightX,
+		RightY,
+		LeftTrigger,
+		RightTrigger,
+		AXIS_COUNT
+	};
+
+	/**
+	 * Segments of each table, the magnitude is interpolated within its segment.
+	 */
+	static constexpr std::size_t LUT_SIZE = 256;
+
+	/**
+	 * One segment of a table: the output at its start, and how much it grows up to its end.
+	 */
+	struct Entry
+	{
+		float value;
+		float slope;
+	};
+
+	// Tables of the left stick, right stick, left trigger and right trigger
+	std::array<std::array<Entry, LUT_SIZE>, 4> tables{};
+	std::array<bool, 2> radial{}; // Per stick
+	bool enabled = false;		  // False if every response is the default one, apply() is then skipped
+
+	/**
+	 * @brief Compiles the responses of the left and right sticks and triggers.
+	 */
+	static AxisTables compile(const AxisResponse &leftStick,
+							  const AxisResponse &rightStick,
+							  const AxisResponse &leftTrigger,
+							  const AxisResponse &rightTrigger);
+
+	/**
+	 * @brief Conditions @p axes in place, in the order of Axis. Axes that are not finite become 0.
+	 */
+	void apply(float (&axes)[AXIS_COUNT]) const;
+
+	/**
+	 * @brief apply() without SIMD, the reference for it.
+	 */
+	void applyScalar(float (&axes)[AXIS_COUNT]) const;
+};
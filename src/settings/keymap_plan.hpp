@@ -0,0 +1,89 @@
+#pragma once
+
+#include "axis_response.hpp"
+#include "input_types.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * @brief A KeymapProfile compiled for injection: flat arrays, precomputed targets, no strings.
+ *
+ * @details
+ * Compiled by the profile whenever its mappings change, then copied by each KeyboardMouseExecutor,
+ * see KeymapProfile::refreshPlan(). Looking an input up is an array index, and the copy is only made
+ * when the profile changed, so the per-reading path neither allocates nor searches a map.
+ */
+struct KeymapPlan
+{
+	/**
+	 * What an input does, resolved once instead of testing the key code on every press.
+	 */
+	enum class Target : uint8_t
+	{
+		None, // Not mapped
+		Key,
+		MouseLeft,
+		MouseRight,
+		MouseMiddle
+	};
+
+	struct Action
+	{
+		Target target = Target::None;
+		InputKeyCode key = 0; // Only for Target::Key
+	};
+
+	struct Stick
+	{
+		bool mouseMove = false;
+		Action up, down, left, right;
+	};
+
+	struct TriggerAction
+	{
+		Action action;
+		float threshold = 0.5f;
+	};
+
+	/**
+	 * One entry per bit of the GamepadButtons mask.
+	 */
+	static constexpr std::size_t BUTTON_COUNT = 32;
+
+	std::array<Action, BUTTON_COUNT> buttons{}; // Indexed by the bit number of the button
+	uint32_t mappedButtons = 0;					// Mask of the buttons with an action
+	std::array<Stick, 2> sticks{};				// Indexed by Thumbstick
+	std::array<TriggerAction, 2> triggers{};	// Indexed by Trigger
+	float hysteresis = 0.1f;					// See KeymapProfile::hysteresis()
+	AxisTables axes;							// See KeymapProfile::stickResponse()
+
+	/**
+	 * @brief The action of a platform key code, 0 maps to nothing.
+	 */
+	static Action action(InputKeyCode vk)
+	{
+		if (vk == 0)
+			return {};
+#ifdef WIN32
+		if (vk == VK_LBUTTON)
+			return {Target::MouseLeft, vk};
+		if (vk == VK_RBUTTON)
+			return {Target::MouseRight, vk};
+		if (vk == VK_MBUTTON)
+			return {Target::MouseMiddle, vk};
+#elif defined(__linux__)
+		if (vk == BTN_LEFT)
+			return {Target::MouseLeft, vk};
+		if (vk == BTN_RIGHT)
+			return {Target::MouseRight, vk};
+		if (vk == BTN_MIDDLE)
+			return {Target::MouseMiddle, vk};
+#endif
+		return {Target::Key, vk};
+	}
+};
+
+static_assert(std::is_trivially_copyable_v<KeymapPlan>, "copied by every executor");
@@ -1,10 +1,11 @@
 #include "keymap_profile.hpp"
 
-#include "../ui/buttoninputbox.hpp"
 #include "settings.hpp"
 
 #include <QDebug>
 #include <QSettings>
+#include <algorithm>
+#include <bit>
 
 #ifdef WIN32
 #include <windows.h>
@@ -12,6 +13,41 @@
 #include <linux/input.h>
 #endif
 
+namespace
+{
+AxisResponse loadResponse(QSettings const &settings, const QString &group)
+{
+	const AxisResponse defaults;
+	AxisResponse response;
+	response.shape = settings.value(group + "/Shape", "radial").toString() == "axial"
+						 ? AxisResponse::Shape::Axial
+						 : AxisResponse::Shape::Radial;
+	response.deadzone = settings.value(group + "/Deadzone", defaults.deadzone).toFloat();
+	response.antiDeadzone = settings.value(group + "/AntiDeadzone", defaults.antiDeadzone).toFloat();
+	response.saturation = settings.value(group + "/Saturation", defaults.saturation).toFloat();
+	response.curve = settings.value(group + "/Curve", "exponent").toString() == "bezier"
+						 ? AxisResponse::Curve::Bezier
+						 : AxisResponse::Curve::Exponent;
+	response.exponent = settings.value(group + "/Exponent", defaults.exponent).toFloat();
+	response.bezier1 = settings.value(group + "/Bezier1", defaults.bezier1).toFloat();
+	response.bezier2 = settings.value(group + "/Bezier2", defaults.bezier2).toFloat();
+	return response.sanitized();
+}
+
+void saveResponse(QSettings &settings, const QString &group, const AxisResponse &response)
+{
+	settings.setValue(group + "/Shape", response.shape == AxisResponse::Shape::Axial ? "axial" : "radial");
+	settings.setValue(group + "/Deadzone", response.deadzone);
+	settings.setValue(group + "/AntiDeadzone", response.antiDeadzone);
+	settings.setValue(group + "/Saturation", response.saturation);
+	settings.setValue(group + "/Curve",
+					  response.curve == AxisResponse::Curve::Bezier ? "bezier" : "exponent");
+	settings.setValue(group + "/Exponent", response.exponent);
+	settings.setValue(group + "/Bezier1", response.bezier1);
+	settings.setValue(group + "/Bezier2", response.bezier2);
+}
+} // namespace
+
 void KeymapProfile::initializeDefaultMappings()
 {
 	// Initialize default display names for buttons
@@ -87,6 +123,10 @@ void KeymapProfile::initializeDefaultMappings()
 	triggerMappings = {{Trigger::Left, {{KEY_LEFTSHIFT, false, "Left Shift"}, 0.5f}},
 					   {Trigger::Right, {{KEY_LEFTCTRL, false, "Left Ctrl"}, 0.5f}}};
 #endif
+	m_hysteresis = DEFAULT_HYSTERESIS;
+	m_stickResponses = {};
+	m_triggerResponses = {};
+	compile();
 }
 
 bool KeymapProfile::load(const QString &profilePath) noexcept
@@ -128,6 +168,7 @@ void KeymapProfile::setButtonInput(GamepadButtons btn, InputKeyCode vk, const QS
 {
 	buttonMappings[btn] = vk;
 	buttonDisplayNames[btn] = displayName;
+	compile();
 }
 
 QString KeymapProfile::buttonDisplayName(GamepadButtons btn) const
@@ -139,6 +180,7 @@ QString KeymapProfile::buttonDisplayName(GamepadButtons btn) const
 void KeymapProfile::setThumbstickInput(Thumbstick thumb, const ThumbstickInput &input)
 {
 	thumbstickMappings[thumb] = input;
+	compile();
 }
 
 ThumbstickInput KeymapProfile::thumbstickInput(Thumbstick thumb) const
@@ -150,6 +192,7 @@ ThumbstickInput KeymapProfile::thumbstickInput(Thumbstick thumb) const
 void KeymapProfile::setLeftThumbMouseMove(bool enabled)
 {
 	thumbstickMappings[Thumbstick_Left].is_mouse_move = enabled;
+	compile();
 }
 
 bool KeymapProfile::leftThumbMouseMove() const
@@ -161,6 +204,7 @@ bool KeymapProfile::leftThumbMouseMove() const
 void KeymapProfile::setRightThumbMouseMove(bool enabled)
 {
 	thumbstickMappings[Thumbstick_Right].is_mouse_move = enabled;
+	compile();
 }
 
 bool KeymapProfile::rightThumbMouseMove() const
@@ -181,9 +225,38 @@ ButtonInput KeymapProfile::buttonInput(GamepadButtons button) const
 	return input;
 }
 
+void KeymapProfile::setHysteresis(float value)
+{
+	m_hysteresis = std::clamp(value, 0.0f, MAX_HYSTERESIS);
+	compile();
+}
+
+AxisResponse KeymapProfile::stickResponse(Thumbstick thumb) const
+{
+	return m_stickResponses[static_cast<std::size_t>(thumb)];
+}
+
+void KeymapProfile::setStickResponse(Thumbstick thumb, const AxisResponse &response)
+{
+	m_stickResponses[static_cast<std::size_t>(thumb)] = response.sanitized();
+	compile();
+}
+
+AxisResponse KeymapProfile::triggerResponse(Trigger trigger) const
+{
+	return m_triggerResponses[static_cast<std::size_t>(trigger)];
+}
+
+void KeymapProfile::setTriggerResponse(Trigger trigger, const AxisResponse &response)
+{
+	m_triggerResponses[static_cast<std::size_t>(trigger)] = response.sanitized();
+	compile();
+}
+
 void KeymapProfile::setTriggerInput(Trigger trigger, const TriggerInput &input)
 {
 	triggerMappings[trigger] = input;
+	compile();
 }
 
 TriggerInput KeymapProfile::triggerInput(Trigger trigger) const
@@ -356,6 +429,67 @@ void KeymapProfile::loadFromSettings(QSettings const &settings)
 
 	triggerMappings[Trigger::Left] = leftTrigger;
 	triggerMappings[Trigger::Right] = rightTrigger;
+
+	m_hysteresis = std::clamp(settings.value("analog/Hysteresis", DEFAULT_HYSTERESIS).toFloat(),
+							  0.0f,
+							  MAX_HYSTERESIS);
+	m_stickResponses[Thumbstick_Left] = loadResponse(settings, "response/LeftStick");
+	m_stickResponses[Thumbstick_Right] = loadResponse(settings, "response/RightStick");
+	m_triggerResponses[static_cast<std::size_t>(Trigger::Left)] =
+		loadResponse(settings, "response/LeftTrigger");
+	m_triggerResponses[static_cast<std::size_t>(Trigger::Right)] =
+		loadResponse(settings, "response/RightTrigger");
+	compile();
+}
+
+void KeymapProfile::refreshPlan(KeymapPlan &plan, uint64_t &generation) const
+{
+	if (m_planGeneration.load(std::memory_order_acquire) == generation) [[likely]]
+		return;
+	std::lock_guard lock(m_planMutex);
+	plan = m_plan;
+	generation = m_planGeneration.load(std::memory_order_relaxed);
+}
+
+void KeymapProfile::compile()
+{
+	KeymapPlan plan;
+	for (const auto &[button, vk] : buttonMappings)
+	{
+		const auto bit = static_cast<uint32_t>(button);
+		if (vk == 0 || !std::has_single_bit(bit))
+			continue;
+		plan.buttons[static_cast<std::size_t>(std::countr_zero(bit))] = KeymapPlan::action(vk);
+		plan.mappedButtons |= bit;
+	}
+	for (const auto &[thumb, input] : thumbstickMappings)
+	{
+		KeymapPlan::Stick &stick = plan.sticks[static_cast<std::size_t>(thumb)];
+		stick.mouseMove = input.is_mouse_move;
+		stick.up = KeymapPlan::action(input.up.vk);
+		stick.down = KeymapPlan::action(input.down.vk);
+		stick.left = KeymapPlan::action(input.left.vk);
+		stick.right = KeymapPlan::action(input.right.vk);
+	}
+	for (const auto &[trigger, input] : triggerMappings)
+	{
+		KeymapPlan::TriggerAction &compiled = plan.triggers[static_cast<std::size_t>(trigger)];
+		compiled.action = KeymapPlan::action(input.button_input.vk);
+		compiled.threshold = input.threshold;
+	}
+	plan.hysteresis = m_hysteresis;
+	// The tables are sampled once here, not per reading
+	plan.axes = AxisTables::compile(m_stickResponses[Thumbstick_Left],
+									m_stickResponses[Thumbstick_Right],
+									m_triggerResponses[static_cast<std::size_t>(Trigger::Left)],
+									m_triggerResponses[static_cast<std::size_t>(Trigger::Right)]);
+
+	// Drawn from one counter for all profiles, so switching to another profile refreshes the executors too
+	static std::atomic<uint64_t> s_generation{0};
+	std::lock_guard lock(m_planMutex);
+	m_plan = plan;
+	const uint64_t generation = s_generation.fetch_add(1, std::memory_order_relaxed) + 1;
+	m_planGeneration.store(generation, std::memory_order_release);
 }
 
 void KeymapProfile::saveToSettings(QSettings &settings) const
@@ -369,6 +503,8 @@ void KeymapProfile::saveToSettings(QSettings &settings) const
 	settings.remove("thumbstick_display_names");
 	settings.remove("triggers");
 	settings.remove("trigger_display_names");
+	settings.remove("analog");
+	settings.remove("response");
 
 	// Button mappings - Use explicit mapping to ensure correct values
 	// Map GamepadButtons directly to settings keys
@@ -465,4 +601,14 @@ void KeymapProfile::saveToSettings(QSettings &settings) const
 	// Trigger display names
 	settings.setValue("trigger_display_names/LeftTrigger", leftTrigger.button_input.displayName);
 	settings.setValue("trigger_display_names/RightTrigger", rightTrigger.button_input.displayName);
+
+	settings.setValue("analog/Hysteresis", m_hysteresis);
+	saveResponse(settings, "response/LeftStick", m_stickResponses[Thumbstick_Left]);
+	saveResponse(settings, "response/RightStick", m_stickResponses[Thumbstick_Right]);
+	saveResponse(settings,
+				 "response/LeftTrigger",
+				 m_triggerResponses[static_cast<std::size_t>(Trigger::Left)]);
+	saveResponse(settings,
+				 "response/RightTrigger",
+				 m_triggerResponses[static_cast<std::size_t>(Trigger::Right)]);
 }
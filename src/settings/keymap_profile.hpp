@@ -1,12 +1,18 @@
 #pragma once
 
+#include "axis_response.hpp"
 #include "input_types.hpp"
+#include "keymap_plan.hpp"
 
 #include <QFile>
 #include <QObject>
 #include <QSettings>
 #include <QString>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <map>
+#include <mutex>
 
 class KeymapProfile : public QObject
 {
@@ -35,6 +41,35 @@ class KeymapProfile : public QObject
 	void setTriggerInput(Trigger trigger, const TriggerInput &input);
 	TriggerInput triggerInput(Trigger trigger) const;
 
+	/**
+	 * @brief How far below its threshold a stick direction or trigger falls before it is released.
+	 *
+	 * Keeps a stick or trigger held right at the threshold from pressing and releasing its key on every
+	 * reading. A fraction of full deflection, at most half of a threshold is taken.
+	 */
+	float hysteresis() const
+	{
+		return m_hysteresis;
+	}
+	void setHysteresis(float value);
+
+	static constexpr float DEFAULT_HYSTERESIS = 0.1f;
+	static constexpr float MAX_HYSTERESIS = 0.5f;
+
+	/**
+	 * @brief Deadzone, saturation and response curve of a stick.
+	 *
+	 * Applied to the stick before anything else, by both executors. The default leaves it unchanged.
+	 */
+	AxisResponse stickResponse(Thumbstick thumb) const;
+	void setStickResponse(Thumbstick thumb, const AxisResponse &response);
+
+	/**
+	 * @brief Deadzone, saturation and response curve of a trigger, see stickResponse().
+	 */
+	AxisResponse triggerResponse(Trigger trigger) const;
+	void setTriggerResponse(Trigger trigger, const AxisResponse &response);
+
 	void setLeftThumbMouseMove(bool enabled);
 	bool leftThumbMouseMove() const;
 	void setRightThumbMouseMove(bool enabled);
@@ -42,6 +77,14 @@ class KeymapProfile : public QObject
 
 	void initializeDefaultMappings();
 
+	/**
+	 * @brief Copies the compiled mappings into @p plan if they changed since @p generation.
+	 *
+	 * Thread safe, and a single atomic load when nothing changed, so call it before every use.
+	 * @param generation 0 the first time, updated with the plan.
+	 */
+	void refreshPlan(KeymapPlan &plan, uint64_t &generation) const;
+
 	// For direct access if needed
 	std::map<GamepadButtons, InputKeyCode> buttonMappings;
 	std::map<GamepadButtons, QString> buttonDisplayNames;
@@ -51,4 +94,17 @@ class KeymapProfile : public QObject
   private:
 	void loadFromSettings(QSettings const &settings);
 	void saveToSettings(QSettings &settings) const;
+
+	/**
+	 * @brief Compiles the mappings into m_plan. Called by everything that changes them.
+	 */
+	void compile();
+
+	float m_hysteresis = DEFAULT_HYSTERESIS;
+	std::array<AxisResponse, 2> m_stickResponses{};	// Indexed by Thumbstick
+	std::array<AxisResponse, 2> m_triggerResponses{}; // Indexed by Trigger
+
+	KeymapPlan m_plan;
+	mutable std::mutex m_planMutex;
+	std::atomic<uint64_t> m_planGeneration{0};
 };
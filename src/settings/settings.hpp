@@ -20,8 +20,12 @@
 namespace setting_keys
 {
 const QString mouse_sensitivity = "mouse_setting/mouse_sensitivity";
+const QString pointer_curve = "mouse_setting/pointer_curve";
 const QString executor_type = "server/executor_type";
 const QString server_port = "server/port";
+const QString server_transport = "server/transport";
+const QString server_injection_rate = "server/injection_rate";
+const QString server_stall_timeout = "server/stall_timeout";
 
 enum button_keys
 {
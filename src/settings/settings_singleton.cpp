@@ -3,11 +3,13 @@
 #include "../appdir.hpp"
 #include "settings.hpp"
 
-#include <QApplication>
 #include <QDebug>
+#include <algorithm>
 
 SettingsSingleton::SettingsSingleton()
 	: settings(QDir::toNativeSeparators(getConfigDir() + "/VirtualGamePad.ini"), QSettings::IniFormat),
+	  pointer_curve(DEFAULT_POINTER_CURVE), transport_mode(DEFAULT_TRANSPORT),
+	  injection_rate(DEFAULT_INJECTION_RATE), stall_timeout(DEFAULT_STALL_TIMEOUT),
 	  executor_type(DEFAULT_EXECUTOR_TYPE)
 {
 	qInfo() << "Settings file path:" << settings.fileName();
@@ -27,8 +29,19 @@ SettingsSingleton::SettingsSingleton()
 
 void SettingsSingleton::setMouseSensitivity(int value)
 {
-	mouse_sensitivity = value;
-	saveSetting(setting_keys::mouse_sensitivity, mouse_sensitivity / MOUSE_SENSITIVITY_MULTIPLIER);
+	mouse_sensitivity.store(value, std::memory_order_relaxed);
+	saveSetting(setting_keys::mouse_sensitivity, value / MOUSE_SENSITIVITY_MULTIPLIER);
+}
+
+void SettingsSingleton::setPointerCurve(double value)
+{
+	usePointerCurve(value);
+	saveSetting(setting_keys::pointer_curve, pointerCurve());
+}
+
+void SettingsSingleton::usePointerCurve(double value)
+{
+	pointer_curve.store(std::clamp(value, MIN_POINTER_CURVE, MAX_POINTER_CURVE), std::memory_order_relaxed);
 }
 
 void SettingsSingleton::setPort(quint16 value)
@@ -37,6 +50,24 @@ void SettingsSingleton::setPort(quint16 value)
 	saveSetting(setting_keys::server_port, port_number);
 }
 
+void SettingsSingleton::setTransport(TransportMode mode)
+{
+	transport_mode = mode;
+	saveSetting(setting_keys::server_transport, static_cast<int>(transport_mode));
+}
+
+void SettingsSingleton::setInjectionRate(int hz)
+{
+	injection_rate = hz;
+	saveSetting(setting_keys::server_injection_rate, injection_rate);
+}
+
+void SettingsSingleton::setStallTimeout(int milliseconds)
+{
+	stall_timeout = std::max(milliseconds, 0);
+	saveSetting(setting_keys::server_stall_timeout, stall_timeout);
+}
+
 void SettingsSingleton::setExecutorType(ExecutorType type)
 {
 	executor_type = type;
@@ -56,8 +87,16 @@ QVariant SettingsSingleton::loadSetting(const QString &key)
 
 void SettingsSingleton::loadMouseSensitivity()
 {
-	mouse_sensitivity = MOUSE_SENSITIVITY_MULTIPLIER *
-						settings.value(setting_keys::mouse_sensitivity, DEFAULT_MOUSE_SENSITIVITY).toInt();
+	mouse_sensitivity.store(
+		MOUSE_SENSITIVITY_MULTIPLIER *
+			settings.value(setting_keys::mouse_sensitivity, DEFAULT_MOUSE_SENSITIVITY).toInt(),
+		std::memory_order_relaxed);
+}
+
+void SettingsSingleton::loadPointerCurve()
+{
+	const double curve = settings.value(setting_keys::pointer_curve, DEFAULT_POINTER_CURVE).toDouble();
+	pointer_curve.store(std::clamp(curve, MIN_POINTER_CURVE, MAX_POINTER_CURVE), std::memory_order_relaxed);
 }
 
 void SettingsSingleton::loadPort()
@@ -66,6 +105,23 @@ void SettingsSingleton::loadPort()
 		static_cast<quint16>(settings.value(setting_keys::server_port, DEFAULT_PORT_NUMBER).toUInt());
 }
 
+void SettingsSingleton::loadTransport()
+{
+	transport_mode = static_cast<TransportMode>(
+		settings.value(setting_keys::server_transport, static_cast<int>(DEFAULT_TRANSPORT)).toInt());
+}
+
+void SettingsSingleton::loadInjectionRate()
+{
+	injection_rate = settings.value(setting_keys::server_injection_rate, DEFAULT_INJECTION_RATE).toInt();
+}
+
+void SettingsSingleton::loadStallTimeout()
+{
+	stall_timeout =
+		std::max(settings.value(setting_keys::server_stall_timeout, DEFAULT_STALL_TIMEOUT).toInt(), 0);
+}
+
 void SettingsSingleton::loadExecutorType()
 {
 	executor_type = static_cast<ExecutorType>(
@@ -77,7 +133,11 @@ void SettingsSingleton::loadAll()
 	try
 	{
 		loadMouseSensitivity();
+		loadPointerCurve();
 		loadPort();
+		loadTransport();
+		loadInjectionRate();
+		loadStallTimeout();
 		loadExecutorType();
 	}
 	catch (const std::exception &e)
@@ -282,10 +342,20 @@ void SettingsSingleton::resetToDefaults()
 {
 	// Reset mouse sensitivity
 	setMouseSensitivity(DEFAULT_MOUSE_SENSITIVITY * MOUSE_SENSITIVITY_MULTIPLIER);
+	setPointerCurve(DEFAULT_POINTER_CURVE);
 
 	// Reset port number
 	setPort(DEFAULT_PORT_NUMBER);
 
+	// Reset transport
+	setTransport(DEFAULT_TRANSPORT);
+
+	// Reset injection rate
+	setInjectionRate(DEFAULT_INJECTION_RATE);
+
+	// Reset stall timeout
+	setStallTimeout(DEFAULT_STALL_TIMEOUT);
+
 	// Reset executor type
 	setExecutorType(DEFAULT_EXECUTOR_TYPE);
 
@@ -11,6 +11,7 @@
 #include <QSettings>
 #include <QString>
 #include <QVariant>
+#include <atomic>
 
 enum class ExecutorType
 {
@@ -18,6 +19,15 @@ enum class ExecutorType
 	KeyboardMouseExecutor
 };
 
+/**
+ * How the client's readings reach the server.
+ */
+enum class TransportMode
+{
+	Tcp, // Reliable, ordered stream of readings
+	Udp	 // Sequence-numbered datagrams, latest state wins
+};
+
 class SettingsSingleton : public QObject
 {
 	Q_OBJECT
@@ -33,18 +43,59 @@ class SettingsSingleton : public QObject
 		return &settings;
 	}
 
+	/**
+	 * Read by the injection threads on every reading, written by the GUI thread.
+	 */
 	int mouseSensitivity() const
 	{
-		return mouse_sensitivity;
+		return mouse_sensitivity.load(std::memory_order_relaxed);
 	}
 	void setMouseSensitivity(int value);
 
+	/**
+	 * Exponent of the pointer acceleration curve of the sticks moving the mouse, 1 is linear.
+	 * Read by the injection threads like mouseSensitivity().
+	 */
+	double pointerCurve() const
+	{
+		return pointer_curve.load(std::memory_order_relaxed);
+	}
+	void setPointerCurve(double value);
+	/**
+	 * Like setPointerCurve(), without saving it, for this run only.
+	 */
+	void usePointerCurve(double value);
+
 	quint16 port() const
 	{
 		return port_number;
 	}
 	void setPort(quint16 value);
 
+	TransportMode transport() const
+	{
+		return transport_mode;
+	}
+	void setTransport(TransportMode mode);
+
+	/**
+	 * Injection ticks per second, 0 injects every reading as soon as it arrives.
+	 */
+	int injectionRate() const
+	{
+		return injection_rate;
+	}
+	void setInjectionRate(int hz);
+
+	/**
+	 * Silence in milliseconds after which the inputs held by a client are released, 0 never does.
+	 */
+	int stallTimeout() const
+	{
+		return stall_timeout;
+	}
+	void setStallTimeout(int milliseconds);
+
 	ExecutorType executorType() const
 	{
 		return executor_type;
@@ -72,7 +123,13 @@ class SettingsSingleton : public QObject
 
 	static constexpr int DEFAULT_MOUSE_SENSITIVITY = 10;
 	static constexpr int MOUSE_SENSITIVITY_MULTIPLIER = 10;
+	static constexpr double DEFAULT_POINTER_CURVE = 1.0;
+	static constexpr double MIN_POINTER_CURVE = 0.5;
+	static constexpr double MAX_POINTER_CURVE = 4.0;
 	static constexpr quint16 DEFAULT_PORT_NUMBER = 0;
+	static constexpr TransportMode DEFAULT_TRANSPORT = TransportMode::Tcp;
+	static constexpr int DEFAULT_INJECTION_RATE = 0;
+	static constexpr int DEFAULT_STALL_TIMEOUT = 500;
 	static constexpr ExecutorType DEFAULT_EXECUTOR_TYPE = ExecutorType::KeyboardMouseExecutor;
 
   private:
@@ -82,14 +139,22 @@ class SettingsSingleton : public QObject
 	SettingsSingleton &operator=(const SettingsSingleton &) = delete;
 
 	QSettings settings;
-	int mouse_sensitivity;
+	std::atomic<int> mouse_sensitivity;	 // Atomic, see mouseSensitivity()
+	std::atomic<double> pointer_curve; // Atomic, see pointerCurve()
 	quint16 port_number;
+	TransportMode transport_mode;
+	int injection_rate;
+	int stall_timeout;
 	ExecutorType executor_type;
 
 	QString m_activeProfileName;
 	KeymapProfile m_activeKeymapProfile;
 
 	void loadMouseSensitivity();
+	void loadPointerCurve();
 	void loadPort();
+	void loadTransport();
+	void loadInjectionRate();
+	void loadStallTimeout();
 	void loadExecutorType();
 };
@@ -14,6 +14,8 @@ using winrt::Windows::UI::Input::Preview::Injection::InputInjector;
 using WinRTGamepadButtons = winrt::Windows::Gaming::Input::GamepadButtons;
 #elif defined(__linux__)
 // Linux includes for gamepad injection
+#include "linux/uinputFrame.hpp"
+
 #include <libevdev/libevdev-uinput.h>
 #include <libevdev/libevdev.h>
 #include <linux/input.h>
@@ -44,6 +46,7 @@ class GamepadInjector
 	std::unique_ptr<libevdev, void (*)(libevdev *)> dev;
 	std::unique_ptr<libevdev_uinput, void (*)(libevdev_uinput *)> uidev;
 	int fd;
+	UinputFrame frame; // Written by inject()
 	// Button states for tracking press/release
 	bool buttonStates[BTN_GAMEPAD - BTN_JOYSTICK + 16]; // Enough for all gamepad buttons
 #endif
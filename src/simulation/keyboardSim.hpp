@@ -13,6 +13,8 @@
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #elif defined(__linux__)
+#include "linux/uinputFrame.hpp"
+
 #include <libevdev/libevdev-uinput.h>
 #include <libevdev/libevdev.h>
 #include <linux/input.h>
@@ -54,10 +56,27 @@ class KeyboardInjector
 	void keyComboDown(std::vector<quint32> nativeKeys);
 	void typeUnicodeString(const QString &str);
 
+	/**
+	 * @brief Holds back the events of keyDown(), keyUp() and the combos until flush().
+	 *
+	 * On Linux they are then written to the device at once, as one report. Elsewhere every call is
+	 * injected right away.
+	 */
+	void batch();
+
+	/**
+	 * @brief Injects the events held back since batch(), and ends it.
+	 */
+	void flush();
+
   private:
 #ifdef _WIN32
 	void addScanCode(INPUT &input, WORD key);
 #elif defined(__linux__)
 	std::unique_ptr<libevdev_uinput, void (*)(libevdev_uinput *)> m_keyboardDevice;
+	UinputFrame m_frame;
+	bool m_batching = false;
+
+	void commit();
 #endif
 };
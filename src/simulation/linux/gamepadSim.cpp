@@ -117,6 +117,7 @@ GamepadInjector::GamepadInjector()
 		throw std::runtime_error("Failed to create uinput device: " + std::string(strerror(-ret)));
 	}
 	uidev.reset(rawUidev);
+	frame.attach(rawUidev);
 
 	qInfo() << "Virtual gamepad created successfully on Linux";
 }
@@ -136,10 +137,10 @@ void GamepadInjector::setThumbsticks(float leftX, float leftY, float rightX, flo
 	int rightYInt = static_cast<int>(-rightY * 32767); // Invert Y axis to match Windows behavior
 
 	// Send the events
-	libevdev_uinput_write_event(uidev.get(), EV_ABS, ABS_X, leftXInt);
-	libevdev_uinput_write_event(uidev.get(), EV_ABS, ABS_Y, leftYInt);
-	libevdev_uinput_write_event(uidev.get(), EV_ABS, ABS_RX, rightXInt);
-	libevdev_uinput_write_event(uidev.get(), EV_ABS, ABS_RY, rightYInt);
+	frame.add(EV_ABS, ABS_X, leftXInt);
+	frame.add(EV_ABS, ABS_Y, leftYInt);
+	frame.add(EV_ABS, ABS_RX, rightXInt);
+	frame.add(EV_ABS, ABS_RY, rightYInt);
 }
 
 void GamepadInjector::setTriggers(float leftTrigger, float rightTrigger)
@@ -148,46 +149,46 @@ void GamepadInjector::setTriggers(float leftTrigger, float rightTrigger)
 	int leftInt = static_cast<int>(leftTrigger * 255);
 	int rightInt = static_cast<int>(rightTrigger * 255);
 
-	libevdev_uinput_write_event(uidev.get(), EV_ABS, ABS_HAT2X, leftInt);
-	libevdev_uinput_write_event(uidev.get(), EV_ABS, ABS_HAT2Y, rightInt);
+	frame.add(EV_ABS, ABS_HAT2X, leftInt);
+	frame.add(EV_ABS, ABS_HAT2Y, rightInt);
 }
 
 void GamepadInjector::pressButton(int buttonCode)
 {
-	libevdev_uinput_write_event(uidev.get(), EV_KEY, buttonCode, 1);
+	frame.add(EV_KEY, buttonCode, 1);
 	if (buttonCode == BTN_DPAD_LEFT)
 	{
-		libevdev_uinput_write_event(uidev.get(), EV_ABS, ABS_HAT0X, -1);
+		frame.add(EV_ABS, ABS_HAT0X, -1);
 	}
 	else if (buttonCode == BTN_DPAD_RIGHT)
 	{
-		libevdev_uinput_write_event(uidev.get(), EV_ABS, ABS_HAT0X, 1);
+		frame.add(EV_ABS, ABS_HAT0X, 1);
 	}
 	else if (buttonCode == BTN_DPAD_UP)
 	{
-		libevdev_uinput_write_event(uidev.get(), EV_ABS, ABS_HAT0Y, -1);
+		frame.add(EV_ABS, ABS_HAT0Y, -1);
 	}
 	else if (buttonCode == BTN_DPAD_DOWN)
 	{
-		libevdev_uinput_write_event(uidev.get(), EV_ABS, ABS_HAT0Y, 1);
+		frame.add(EV_ABS, ABS_HAT0Y, 1);
 	}
 }
 
 void GamepadInjector::releaseButton(int buttonCode)
 {
-	libevdev_uinput_write_event(uidev.get(), EV_KEY, buttonCode, 0);
+	frame.add(EV_KEY, buttonCode, 0);
 	if (buttonCode == BTN_DPAD_LEFT || buttonCode == BTN_DPAD_RIGHT)
 	{
-		libevdev_uinput_write_event(uidev.get(), EV_ABS, ABS_HAT0X, 0);
+		frame.add(EV_ABS, ABS_HAT0X, 0);
 	}
 	else if (buttonCode == BTN_DPAD_UP || buttonCode == BTN_DPAD_DOWN)
 	{
-		libevdev_uinput_write_event(uidev.get(), EV_ABS, ABS_HAT0Y, 0);
+		frame.add(EV_ABS, ABS_HAT0Y, 0);
 	}
 }
 
 void GamepadInjector::inject()
 {
-	// Send sync event to commit all changes
-	libevdev_uinput_write_event(uidev.get(), EV_SYN, SYN_REPORT, 0);
+	// Write every change with one sync event to commit them
+	frame.flush();
 }
@@ -1,7 +1,6 @@
 #include "../keyboardSim.hpp"
 
 #include <QDebug>
-#include <QKeySequence>
 #include <QThread>
 #include <Qt>
 #include <cstring>
@@ -55,6 +54,7 @@ KeyboardInjector::KeyboardInjector() : m_keyboardDevice(nullptr, libevdev_uinput
 	}
 
 	m_keyboardDevice.reset(uidev);
+	m_frame.attach(uidev);
 	qDebug() << "Virtual keyboard device created successfully";
 }
 
@@ -74,15 +74,15 @@ void KeyboardInjector::pressKey(quint32 nativeKeyCode)
 		return;
 
 	// Press key
-	libevdev_uinput_write_event(m_keyboardDevice.get(), EV_KEY, linuxKey, 1);
-	libevdev_uinput_write_event(m_keyboardDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_KEY, static_cast<uint16_t>(linuxKey), 1);
+	m_frame.flush();
 
 	// Wait
 	QThread::msleep(PRESS_INTERVAL);
 
 	// Release key
-	libevdev_uinput_write_event(m_keyboardDevice.get(), EV_KEY, linuxKey, 0);
-	libevdev_uinput_write_event(m_keyboardDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_KEY, static_cast<uint16_t>(linuxKey), 0);
+	m_frame.flush();
 }
 
 void KeyboardInjector::pressKeyCombo(std::vector<quint32> nativeKeys)
@@ -96,10 +96,10 @@ void KeyboardInjector::pressKeyCombo(std::vector<quint32> nativeKeys)
 		int linuxKey = static_cast<int>(nativeKeyCode);
 		if (linuxKey != KEY_RESERVED)
 		{
-			libevdev_uinput_write_event(m_keyboardDevice.get(), EV_KEY, linuxKey, 1);
+			m_frame.add(EV_KEY, static_cast<uint16_t>(linuxKey), 1);
 		}
 	}
-	libevdev_uinput_write_event(m_keyboardDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.flush();
 
 	// Wait
 	QThread::msleep(PRESS_INTERVAL);
@@ -110,10 +110,10 @@ void KeyboardInjector::pressKeyCombo(std::vector<quint32> nativeKeys)
 		int linuxKey = static_cast<int>(nativeKeyCode);
 		if (linuxKey != KEY_RESERVED)
 		{
-			libevdev_uinput_write_event(m_keyboardDevice.get(), EV_KEY, linuxKey, 0);
+			m_frame.add(EV_KEY, static_cast<uint16_t>(linuxKey), 0);
 		}
 	}
-	libevdev_uinput_write_event(m_keyboardDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.flush();
 }
 
 void KeyboardInjector::keyDown(quint32 nativeKeyCode)
@@ -125,8 +125,8 @@ void KeyboardInjector::keyDown(quint32 nativeKeyCode)
 	if (linuxKey == KEY_RESERVED)
 		return;
 
-	libevdev_uinput_write_event(m_keyboardDevice.get(), EV_KEY, linuxKey, 1);
-	libevdev_uinput_write_event(m_keyboardDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_KEY, static_cast<uint16_t>(linuxKey), 1);
+	commit();
 }
 
 void KeyboardInjector::keyUp(quint32 nativeKeyCode)
@@ -138,8 +138,8 @@ void KeyboardInjector::keyUp(quint32 nativeKeyCode)
 	if (linuxKey == KEY_RESERVED)
 		return;
 
-	libevdev_uinput_write_event(m_keyboardDevice.get(), EV_KEY, linuxKey, 0);
-	libevdev_uinput_write_event(m_keyboardDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_KEY, static_cast<uint16_t>(linuxKey), 0);
+	commit();
 }
 
 void KeyboardInjector::keyComboUp(std::vector<quint32> nativeKeys)
@@ -152,10 +152,10 @@ void KeyboardInjector::keyComboUp(std::vector<quint32> nativeKeys)
 		int linuxKey = static_cast<int>(nativeKeyCode);
 		if (linuxKey != KEY_RESERVED)
 		{
-			libevdev_uinput_write_event(m_keyboardDevice.get(), EV_KEY, linuxKey, 0);
+			m_frame.add(EV_KEY, static_cast<uint16_t>(linuxKey), 0);
 		}
 	}
-	libevdev_uinput_write_event(m_keyboardDevice.get(), EV_SYN, SYN_REPORT, 0);
+	commit();
 }
 
 void KeyboardInjector::keyComboDown(std::vector<quint32> nativeKeys)
@@ -168,10 +168,27 @@ void KeyboardInjector::keyComboDown(std::vector<quint32> nativeKeys)
 		int linuxKey = static_cast<int>(nativeKeyCode);
 		if (linuxKey != KEY_RESERVED)
 		{
-			libevdev_uinput_write_event(m_keyboardDevice.get(), EV_KEY, linuxKey, 1);
+			m_frame.add(EV_KEY, static_cast<uint16_t>(linuxKey), 1);
 		}
 	}
-	libevdev_uinput_write_event(m_keyboardDevice.get(), EV_SYN, SYN_REPORT, 0);
+	commit();
+}
+
+void KeyboardInjector::batch()
+{
+	m_batching = true;
+}
+
+void KeyboardInjector::flush()
+{
+	m_batching = false;
+	m_frame.flush();
+}
+
+void KeyboardInjector::commit()
+{
+	if (!m_batching)
+		m_frame.flush();
 }
 
 void KeyboardInjector::typeUnicodeString(const QString &str)
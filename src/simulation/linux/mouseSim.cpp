@@ -65,6 +65,7 @@ void MouseInjector::ensureDevice()
 	}
 
 	m_mouseDevice.reset(uidev);
+	m_frame.attach(uidev);
 	qDebug() << "Virtual mouse device created successfully";
 }
 
@@ -85,16 +86,16 @@ void MouseInjector::moveMouseByOffset(int x, int y)
 
 	if (x != 0)
 	{
-		libevdev_uinput_write_event(m_mouseDevice.get(), EV_REL, REL_X, x);
+		m_frame.add(EV_REL, REL_X, x);
 	}
 	if (y != 0)
 	{
-		libevdev_uinput_write_event(m_mouseDevice.get(), EV_REL, REL_Y, y);
+		m_frame.add(EV_REL, REL_Y, y);
 	}
 
 	if (x != 0 || y != 0)
 	{
-		libevdev_uinput_write_event(m_mouseDevice.get(), EV_SYN, SYN_REPORT, 0);
+		commit();
 	}
 }
 
@@ -119,14 +120,14 @@ void MouseInjector::leftClick()
 		return;
 
 	// Press
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_KEY, BTN_LEFT, 1);
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_KEY, BTN_LEFT, 1);
+	m_frame.flush();
 
 	QThread::msleep(ClickHoldTime);
 
 	// Release
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_KEY, BTN_LEFT, 0);
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_KEY, BTN_LEFT, 0);
+	m_frame.flush();
 }
 
 void MouseInjector::rightClick()
@@ -136,14 +137,14 @@ void MouseInjector::rightClick()
 		return;
 
 	// Press
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_KEY, BTN_RIGHT, 1);
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_KEY, BTN_RIGHT, 1);
+	m_frame.flush();
 
 	QThread::msleep(ClickHoldTime);
 
 	// Release
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_KEY, BTN_RIGHT, 0);
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_KEY, BTN_RIGHT, 0);
+	m_frame.flush();
 }
 
 void MouseInjector::middleClick()
@@ -153,14 +154,14 @@ void MouseInjector::middleClick()
 		return;
 
 	// Press
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_KEY, BTN_MIDDLE, 1);
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_KEY, BTN_MIDDLE, 1);
+	m_frame.flush();
 
 	QThread::msleep(ClickHoldTime);
 
 	// Release
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_KEY, BTN_MIDDLE, 0);
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_KEY, BTN_MIDDLE, 0);
+	m_frame.flush();
 }
 
 void MouseInjector::leftDown()
@@ -169,8 +170,8 @@ void MouseInjector::leftDown()
 	if (!m_mouseDevice)
 		return;
 
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_KEY, BTN_LEFT, 1);
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_KEY, BTN_LEFT, 1);
+	commit();
 }
 
 void MouseInjector::leftUp()
@@ -179,8 +180,8 @@ void MouseInjector::leftUp()
 	if (!m_mouseDevice)
 		return;
 
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_KEY, BTN_LEFT, 0);
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_KEY, BTN_LEFT, 0);
+	commit();
 }
 
 void MouseInjector::rightDown()
@@ -189,8 +190,8 @@ void MouseInjector::rightDown()
 	if (!m_mouseDevice)
 		return;
 
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_KEY, BTN_RIGHT, 1);
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_KEY, BTN_RIGHT, 1);
+	commit();
 }
 
 void MouseInjector::rightUp()
@@ -199,8 +200,8 @@ void MouseInjector::rightUp()
 	if (!m_mouseDevice)
 		return;
 
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_KEY, BTN_RIGHT, 0);
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_KEY, BTN_RIGHT, 0);
+	commit();
 }
 
 void MouseInjector::middleDown()
@@ -209,8 +210,8 @@ void MouseInjector::middleDown()
 	if (!m_mouseDevice)
 		return;
 
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_KEY, BTN_MIDDLE, 1);
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_KEY, BTN_MIDDLE, 1);
+	commit();
 }
 
 void MouseInjector::middleUp()
@@ -219,8 +220,8 @@ void MouseInjector::middleUp()
 	if (!m_mouseDevice)
 		return;
 
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_KEY, BTN_MIDDLE, 0);
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_KEY, BTN_MIDDLE, 0);
+	commit();
 }
 
 void MouseInjector::scrollUp()
@@ -229,8 +230,8 @@ void MouseInjector::scrollUp()
 	if (!m_mouseDevice)
 		return;
 
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_REL, REL_WHEEL, 1);
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_REL, REL_WHEEL, 1);
+	commit();
 }
 
 void MouseInjector::scrollDown()
@@ -239,6 +240,23 @@ void MouseInjector::scrollDown()
 	if (!m_mouseDevice)
 		return;
 
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_REL, REL_WHEEL, -1);
-	libevdev_uinput_write_event(m_mouseDevice.get(), EV_SYN, SYN_REPORT, 0);
+	m_frame.add(EV_REL, REL_WHEEL, -1);
+	commit();
+}
+
+void MouseInjector::batch()
+{
+	m_batching = true;
+}
+
+void MouseInjector::flush()
+{
+	m_batching = false;
+	m_frame.flush();
+}
+
+void MouseInjector::commit()
+{
+	if (!m_batching)
+		m_frame.flush();
 }
@@ -0,0 +1,68 @@
+#include "uinputFrame.hpp"
+
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <libevdev/libevdev-uinput.h>
+#include <unistd.h>
+
+std::atomic<uint64_t> UinputFrame::s_writes{0};
+std::atomic<uint64_t> UinputFrame::s_events{0};
+
+void UinputFrame::attach(libevdev_uinput *device)
+{
+	m_fd = device != nullptr ? libevdev_uinput_get_fd(device) : -1;
+	m_count = 0;
+}
+
+void UinputFrame::add(uint16_t type, uint16_t code, int32_t value)
+{
+	if (m_fd < 0)
+		return;
+	if (m_count == CAPACITY) [[unlikely]]
+	{
+		// The kernel applies the events on the SYN_REPORT only, so the frame stays whole
+		write(m_count);
+		m_count = 0;
+	}
+
+	// Zero time, the kernel stamps the events
+	input_event &event = m_events[m_count++];
+	event = {};
+	event.type = type;
+	event.code = code;
+	event.value = value;
+}
+
+void UinputFrame::flush()
+{
+	if (m_count == 0)
+		return;
+	input_event &report = m_events[m_count++];
+	report = {};
+	report.type = EV_SYN;
+	report.code = SYN_REPORT;
+	write(m_count);
+	m_count = 0;
+}
+
+UinputFrame::Counters UinputFrame::counters()
+{
+	return {s_writes.load(std::memory_order_relaxed), s_events.load(std::memory_order_relaxed)};
+}
+
+void UinputFrame::write(std::size_t count)
+{
+	const std::size_t bytes = count * sizeof(input_event);
+	ssize_t written = 0;
+	do
+	{
+		written = ::write(m_fd, m_events.data(), bytes);
+	} while (written < 0 && errno == EINTR);
+
+	s_writes.fetch_add(1, std::memory_order_relaxed);
+	s_events.fetch_add(count, std::memory_order_relaxed);
+	if (written != static_cast<ssize_t>(bytes)) [[unlikely]]
+		qWarning() << "Failed to write to the uinput device:"
+				   << (written < 0 ? strerror(errno) : "short write");
+}
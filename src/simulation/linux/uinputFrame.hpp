@@ -0,0 +1,63 @@
+/**
+ * @file uinputFrame.hpp
+ * @brief Batches the events written to a uinput device (Linux).
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <linux/input.h>
+
+struct libevdev_uinput;
+
+/**
+ * @brief Events for one uinput device, written with a single write() that ends in one SYN_REPORT.
+ *
+ * @details
+ * libevdev_uinput_write_event() makes one syscall per event, and the injectors used to follow every
+ * key or button with a SYN_REPORT of its own. Instead, the injectors add their events to a frame and
+ * flush it once per reading. Readers of the device then see all the changes of a reading as one report.
+ *
+ * The counters are process-wide, so the benchmarks can compare the writes made with the events written,
+ * which is what the writes used to be.
+ */
+class UinputFrame
+{
+  public:
+	/**
+	 * Events queued before a full frame is written early, without its SYN_REPORT.
+	 */
+	static constexpr std::size_t CAPACITY = 64;
+
+	struct Counters
+	{
+		uint64_t writes = 0; // write() syscalls
+		uint64_t events = 0; // Events written, SYN_REPORTs included
+	};
+
+	/**
+	 * @brief Writes to @p device from now on, nullptr drops the events.
+	 */
+	void attach(libevdev_uinput *device);
+
+	void add(uint16_t type, uint16_t code, int32_t value);
+
+	/**
+	 * @brief Writes the queued events and a SYN_REPORT, does nothing if no event is queued.
+	 */
+	void flush();
+
+	static Counters counters();
+
+  private:
+	void write(std::size_t count);
+
+	int m_fd = -1;
+	std::array<input_event, CAPACITY + 1> m_events{}; // One more for the SYN_REPORT
+	std::size_t m_count = 0;
+
+	static std::atomic<uint64_t> s_writes;
+	static std::atomic<uint64_t> s_events;
+};
@@ -9,6 +9,8 @@
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #elif defined(__linux__)
+#include "linux/uinputFrame.hpp"
+
 #include <libevdev/libevdev-uinput.h>
 #include <libevdev/libevdev.h>
 #include <linux/input.h>
@@ -81,11 +83,28 @@ class MouseInjector
 	void scrollUp();
 	void scrollDown();
 
+	/**
+	 * @brief Holds back the events of the moves, presses, releases and scrolls until flush().
+	 *
+	 * On Linux they are then written to the device at once, as one report. Elsewhere every call is
+	 * injected right away. The clicks always inject right away, they wait between their events.
+	 */
+	void batch();
+
+	/**
+	 * @brief Injects the events held back since batch(), and ends it.
+	 */
+	void flush();
+
   private:
 	static constexpr unsigned int ClickHoldTime = 10; // Time to hold the click in milliseconds
 
 #ifdef __linux__
 	std::unique_ptr<libevdev_uinput, void (*)(libevdev_uinput *)> m_mouseDevice;
+	UinputFrame m_frame;
+	bool m_batching = false;
+
 	void ensureDevice();
+	void commit();
 #endif
 };
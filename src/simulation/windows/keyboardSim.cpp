@@ -1,6 +1,5 @@
 #include "../keyboardSim.hpp"
 
-#include <QKeySequence>
 #include <unordered_set>
 
 /**
@@ -135,6 +134,15 @@ void KeyboardInjector::keyComboDown(std::vector<quint32> nativeKeys)
 	SendInput(static_cast<UINT>(nativeKeys.size()), inputs.data(), sizeof(INPUT));
 }
 
+void KeyboardInjector::batch()
+{
+	// Every call is injected right away
+}
+
+void KeyboardInjector::flush()
+{
+}
+
 void KeyboardInjector::typeUnicodeString(const QString &str)
 {
 	std::wstring wstr = str.toStdWString();
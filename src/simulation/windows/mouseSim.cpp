@@ -160,3 +160,12 @@ void MouseInjector::scrollDown()
 	input.mi.mouseData = -WHEEL_DELTA;
 	SendInput(1, &input, sizeof(INPUT));
 }
+
+void MouseInjector::batch()
+{
+	// Every call is injected right away
+}
+
+void MouseInjector::flush()
+{
+}
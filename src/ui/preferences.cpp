@@ -13,6 +13,14 @@
 #include <QMessageBox>
 #include <QSlider>
 #include <QStandardPaths>
+#include <algorithm>
+#include <array>
+
+namespace
+{
+// Rates offered by injectionRateComboBox, in the order of its items
+constexpr std::array<int, 4> INJECTION_RATES = {0, 250, 500, 1000};
+} // namespace
 
 Preferences::Preferences(QWidget *parent) : QWidget(parent), ui(new Ui::Preferences)
 {
@@ -46,12 +54,16 @@ Preferences::Preferences(QWidget *parent) : QWidget(parent), ui(new Ui::Preferen
 
 	ui->buttonBox->setCenterButtons(true);
 	ui->pointerSlider->setValue(SettingsSingleton::instance().mouseSensitivity() / 100);
+	ui->pointerCurveSpinBox->setValue(SettingsSingleton::instance().pointerCurve());
 	ui->executorNotesLabel->setOpenExternalLinks(true);
 
 	setup_profile_management();
 
 	// Load preferences into UI
 	load_port();
+	load_transport();
+	load_injection_rate();
+	load_stall_timeout();
 	load_executor_type();
 
 	// Connect executor type radio buttons
@@ -72,10 +84,20 @@ Preferences::Preferences(QWidget *parent) : QWidget(parent), ui(new Ui::Preferen
 
 				// Save mouse sensitivity
 				settings.setMouseSensitivity(ui->pointerSlider->value() * 100);
+				settings.setPointerCurve(ui->pointerCurveSpinBox->value());
 
 				// Save port number now
 				settings.setPort(static_cast<quint16>(ui->portSpinBox->value()));
 
+				// Save transport
+				settings.setTransport(static_cast<TransportMode>(ui->transportComboBox->currentIndex()));
+
+				// Save injection rate
+				settings.setInjectionRate(INJECTION_RATES[ui->injectionRateComboBox->currentIndex()]);
+
+				// Save stall timeout
+				settings.setStallTimeout(ui->stallTimeoutSpinBox->value());
+
 				// Save executor type
 				ExecutorType executorType = ui->gamepadExecutorRadio->isChecked()
 												? ExecutorType::GamepadExecutor
@@ -446,6 +468,25 @@ void Preferences::load_port()
 	ui->portSpinBox->setValue(port);
 }
 
+void Preferences::load_transport()
+{
+	ui->transportComboBox->setCurrentIndex(static_cast<int>(SettingsSingleton::instance().transport()));
+}
+
+void Preferences::load_injection_rate()
+{
+	const int rate = SettingsSingleton::instance().injectionRate();
+	auto it = std::find(INJECTION_RATES.begin(), INJECTION_RATES.end(), rate);
+	// A rate edited by hand into the ini falls back to injecting on arrival
+	ui->injectionRateComboBox->setCurrentIndex(
+		it == INJECTION_RATES.end() ? 0 : static_cast<int>(it - INJECTION_RATES.begin()));
+}
+
+void Preferences::load_stall_timeout()
+{
+	ui->stallTimeoutSpinBox->setValue(SettingsSingleton::instance().stallTimeout());
+}
+
 void Preferences::change_port(int value)
 {
 	SettingsSingleton::instance().setPort(static_cast<quint16>(value));
@@ -469,6 +510,7 @@ void Preferences::restore_defaults()
 
 	// Update UI to reflect the default values
 	ui->pointerSlider->setValue(SettingsSingleton::DEFAULT_MOUSE_SENSITIVITY);
+	ui->pointerCurveSpinBox->setValue(SettingsSingleton::DEFAULT_POINTER_CURVE);
 	ui->portSpinBox->setValue(SettingsSingleton::DEFAULT_PORT_NUMBER);
 	if (SettingsSingleton::DEFAULT_EXECUTOR_TYPE == ExecutorType::GamepadExecutor)
 	{
@@ -482,6 +524,9 @@ void Preferences::restore_defaults()
 	// Refresh UI to show the default values
 	load_keys();
 	load_port();
+	load_transport();
+	load_injection_rate();
+	load_stall_timeout();
 	load_executor_type();
 
 	QMessageBox::information(this,
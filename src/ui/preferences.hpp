@@ -25,6 +25,9 @@ class Preferences : public QWidget
 	void load_thumbsticks();
 	void load_triggers();
 	void load_port();
+	void load_transport();
+	void load_injection_rate();
+	void load_stall_timeout();
 	void load_executor_type();
   private slots:
 	void show_help();
@@ -0,0 +1,121 @@
+/**
+ * @file axis_response_check.cpp
+ * @brief Checks that AxisTables::apply() computes exactly what AxisTables::applyScalar() does.
+ *
+ * @details
+ * apply() runs on SSE2 where available, applyScalar() is its reference. Both condition readings
+ * mixing random deflections with NaN, infinities, huge values, denormals and signed zeros, through
+ * radial and axial sticks, exponent and Bezier curves, and extreme deadzones. Every output must be
+ * bit-identical on both paths, finite and within [-1, 1].
+ *
+ * Usage: axis_response_check [readings per table set, default 2000000]
+ * Exits with 1 and prints the first differing reading otherwise.
+ */
+
+#include "../src/settings/axis_response.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+std::vector<AxisTables> tableSets()
+{
+	AxisResponse radial;
+	radial.deadzone = 0.1f;
+	radial.antiDeadzone = 0.05f;
+	radial.saturation = 0.95f;
+	radial.exponent = 2.0f;
+
+	AxisResponse bezier = radial;
+	bezier.shape = AxisResponse::Shape::Axial;
+	bezier.curve = AxisResponse::Curve::Bezier;
+	bezier.bezier1 = 0.1f;
+	bezier.bezier2 = 0.9f;
+
+	AxisResponse steep;
+	steep.deadzone = 0.9f;
+	steep.exponent = 10.0f;
+
+	AxisResponse flat;
+	flat.shape = AxisResponse::Shape::Axial;
+	flat.antiDeadzone = 0.9f;
+	flat.exponent = 0.1f;
+
+	return {AxisTables::compile(radial, bezier, radial, bezier),
+			AxisTables::compile(bezier, radial, bezier, radial),
+			AxisTables::compile(steep, flat, flat, steep),
+			AxisTables::compile(AxisResponse{}, steep, AxisResponse{}, flat)};
+}
+
+bool sameBits(float a, float b)
+{
+	uint32_t bitsA = 0;
+	uint32_t bitsB = 0;
+	std::memcpy(&bitsA, &a, sizeof(a));
+	std::memcpy(&bitsB, &b, sizeof(b));
+	return bitsA == bitsB;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	const unsigned long readings = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+
+	constexpr float NaN = std::numeric_limits<float>::quiet_NaN();
+	constexpr float INF = std::numeric_limits<float>::infinity();
+	constexpr float DENORMAL = std::numeric_limits<float>::denorm_min();
+	const float specials[] = {
+		NaN, -NaN, INF, -INF, 1e30f, -1e30f, DENORMAL, -DENORMAL, 0.0f, -0.0f, 1.0f, -1.0f};
+	constexpr std::size_t SPECIAL_COUNT = sizeof(specials) / sizeof(specials[0]);
+
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<float> deflection(-1.0f, 1.0f);
+	std::uniform_int_distribution<std::size_t> special(0, SPECIAL_COUNT - 1);
+	std::uniform_int_distribution<int> oneIn(0, 3);
+
+	const std::vector<AxisTables> sets = tableSets();
+	for (std::size_t set = 0; set < sets.size(); set++)
+	{
+		for (unsigned long n = 0; n < readings; n++)
+		{
+			float input[AxisTables::AXIS_COUNT];
+			for (float &axis : input)
+				axis = oneIn(generator) == 0 ? specials[special(generator)] : deflection(generator);
+
+			float simd[AxisTables::AXIS_COUNT];
+			float scalar[AxisTables::AXIS_COUNT];
+			std::memcpy(simd, input, sizeof(input));
+			std::memcpy(scalar, input, sizeof(input));
+			sets[set].apply(simd);
+			sets[set].applyScalar(scalar);
+
+			for (std::size_t i = 0; i < AxisTables::AXIS_COUNT; i++)
+			{
+				if (sameBits(simd[i], scalar[i]) && std::isfinite(simd[i]) && std::abs(simd[i]) <= 1.0f)
+					continue;
+				std::printf("axis_response_check: table set %zu, reading %lu, axis %zu: apply %a, "
+							"applyScalar %a\ninput:",
+							set,
+							n,
+							i,
+							simd[i],
+							scalar[i]);
+				for (float axis : input)
+					std::printf(" %a", axis);
+				std::printf("\n");
+				return 1;
+			}
+		}
+	}
+	std::printf("axis_response_check: %zu table sets, %lu readings each, apply and applyScalar agree\n",
+				sets.size(),
+				readings);
+	return 0;
+}
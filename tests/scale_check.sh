@@ -0,0 +1,81 @@
+#!/bin/sh
+# Scale check: many loopback clients at once against one vgpd, each with its own virtual gamepad.
+# Fails if a connection failed, a session dropped a reading or had a parse error, or a session is missing.
+# Skipped (exit code 77) where /dev/uinput cannot be opened, the server needs it for the devices.
+#
+# Usage: scale_check.sh <vgpd> <vgp-loadgen> [connections] [seconds]
+
+set -u
+
+VGPD=$1
+LOADGEN=$2
+CONNECTIONS=${3:-16}
+DURATION=${4:-5}
+
+if [ ! -w /dev/uinput ]; then
+	echo "scale_check: /dev/uinput is not writable, skipped"
+	exit 77
+fi
+
+WORK=$(mktemp -d)
+SERVER=
+cleanup() {
+	if [ -n "$SERVER" ]; then
+		kill "$SERVER" 2>/dev/null
+		wait "$SERVER" 2>/dev/null
+	fi
+	rm -rf "$WORK"
+}
+trap cleanup EXIT
+
+# Port 0 picks a free port, printed on stdout. --stats prints the final stats of every session it closes.
+"$VGPD" --port 0 --transport tcp --executor gamepad --stats >"$WORK/server.log" 2>"$WORK/server.err" &
+SERVER=$!
+
+PORT=
+for _ in $(seq 100); do
+	PORT=$(sed -n 's/^listening tcp \([0-9]*\)$/\1/p' "$WORK/server.log")
+	if [ -n "$PORT" ] || ! kill -0 "$SERVER" 2>/dev/null; then
+		break
+	fi
+	sleep 0.1
+done
+if [ -z "$PORT" ]; then
+	echo "scale_check: vgpd did not start listening"
+	cat "$WORK/server.err"
+	exit 1
+fi
+
+"$LOADGEN" --port "$PORT" --connections "$CONNECTIONS" --rate 1000 --pattern mash --duration "$DURATION" \
+	>"$WORK/loadgen.log"
+LOADGEN_STATUS=$?
+cat "$WORK/loadgen.log"
+
+# Lets the server notice the disconnections and print the final stats
+sleep 1
+kill "$SERVER"
+wait "$SERVER"
+SERVER=
+
+FAILED=$(sed -n 's/^connections failed=\([0-9]*\).*/\1/p' "$WORK/loadgen.log")
+SESSIONS=$(sed -n 's/^session=\([0-9]*\) .*/\1/p' "$WORK/server.log" | sort -u | wc -l)
+LOSSES=$(grep -E ' (dropped|parse_errors)=[1-9]' "$WORK/server.log")
+
+STATUS=0
+if [ "$LOADGEN_STATUS" -ne 0 ] || [ "${FAILED:-1}" -ne 0 ]; then
+	echo "scale_check: ${FAILED:-all} of $CONNECTIONS connections failed"
+	STATUS=1
+fi
+if [ "$SESSIONS" -lt "$CONNECTIONS" ]; then
+	echo "scale_check: the server reported $SESSIONS sessions of $CONNECTIONS"
+	STATUS=1
+fi
+if [ -n "$LOSSES" ]; then
+	echo "scale_check: sessions dropped readings or failed to parse them:"
+	echo "$LOSSES"
+	STATUS=1
+fi
+if [ "$STATUS" -eq 0 ]; then
+	echo "scale_check: $SESSIONS sessions, no reading dropped, no parse error"
+fi
+exit "$STATUS"